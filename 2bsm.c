@@ -4,6 +4,7 @@
  * @license MIT **/
 #include "2bsm.h"
 #include "util.h"
+#include "compile.h"
 #include <assert.h>
 #include <time.h>
 
@@ -105,33 +106,37 @@ static int comment(FILE * o, unsigned depth, const char *fmt, ...)
 	return -1;
 }
 
-static int signal2bsm(signal_t * sig, FILE * o, unsigned depth)
+static int signal2bsm(const char *name, unsigned bit_length, FILE * o, unsigned depth)
 {
-	assert(sig);
+	assert(name);
 	assert(o);
 	UNUSED(depth);
 
-	if (sig->bit_length > 16) { /* We need to split it into two, because we assume a <BB> is a 16 bit element (0xXX 0x00) */
-		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s (LSB)\" Bits=\"0\" Size=\"%d\" />\n", sig->name, 16);
-		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s (MSB)\" Bits=\"0\" Size=\"%d\" />\n", sig->name, sig->bit_length - 16);
+	if (bit_length > 16) { /* We need to split it into two, because we assume a <BB> is a 16 bit element (0xXX 0x00) */
+		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s (LSB)\" Bits=\"0\" Size=\"%d\" />\n", name, 16);
+		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s (MSB)\" Bits=\"0\" Size=\"%d\" />\n", name, (int)bit_length - 16);
 } else {
-		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s\" Bits=\"0\" Size=\"%d\" />\n", sig->name, sig->bit_length);
+		fprintf(o, "\t\t\t\t\t\t\t\t\t<BB Name=\"%s\" Bits=\"0\" Size=\"%d\" />\n", name, (int)bit_length);
 	}
 
 	return 0;
 }
 
-static int msg2bsm(can_msg_t * msg, FILE * o, unsigned depth)
+static int msg2bsm(const compiled_t *c, const compiled_message_t *msg, FILE * o, unsigned depth)
 {
+	assert(c);
 	assert(msg);
 	assert(o);
+	const char *name = msg->message->name;
+	const compiled_signal_t *sigs = &c->signals[msg->first];
+	const compiled_meta_t *meta = &c->meta[msg->first];
 	indent(o, depth);
 
 	unsigned last_bit = 0;	/* Detect gaps between signals */
 
 	unsigned int padding_size = 0;	/* Find how much we need to pad the data to, 8, 16, 24, or 32 */
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *sig = msg->sigs[i];
+	for (size_t i = 0; i < msg->count; i++) {
+		const compiled_signal_t *sig = &sigs[i];
 
 		if (last_bit < sig->start_bit) {
 			/* We have a void, create a fake signal of UNKNOWN in the middle */
@@ -154,39 +159,31 @@ static int msg2bsm(can_msg_t * msg, FILE * o, unsigned depth)
 		padding_size = 32;
 	}
 
-	fprintf(o, BSM_MESSAGE_PREFIX, msg->name, msg->id, msg->id, padding_size);
+	fprintf(o, BSM_MESSAGE_PREFIX, name, msg->id, msg->id, padding_size);
 
 	last_bit = 0;
-	signal_t *multiplexor = NULL;
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *sig = msg->sigs[i];
-		if (sig->is_multiplexor) {
+	bool multiplexor = false;
+	for (size_t i = 0; i < msg->count; i++) {
+		const compiled_signal_t *sig = &sigs[i];
+		if (sig->flags & COMPILED_MULTIPLEXOR) {
 			if (multiplexor) {
-				error ("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", msg->name);
+				error ("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", name);
 				return -1;
 			}
-			multiplexor = sig;
+			multiplexor = true;
 			continue;
 		}
-		if (sig->is_multiplexed)
+		if (sig->flags & COMPILED_MULTIPLEXED)
 			continue;
 
 		if (last_bit < sig->start_bit) {
 			/* We have a void, create a fake signal of UNKNOWN in the middle */
-			char szUNKNOWN[] = "UNKNOWN";
-			char szUNITS[] = "";
-			signal_t unknownsig = { 0 };
-			unknownsig.name = szUNKNOWN;
-			unknownsig.units = szUNITS;
-			unknownsig.start_bit = last_bit;
-			unknownsig.bit_length = sig->start_bit - last_bit;
-
-			if (signal2bsm(&unknownsig, o, depth + 1) < 0)
+			if (signal2bsm("UNKNOWN", sig->start_bit - last_bit, o, depth + 1) < 0)
 				return -1;
 
 			last_bit = sig->start_bit;
 		}
-		if (signal2bsm(sig, o, depth + 1) < 0)
+		if (signal2bsm(meta[i].name, sig->bit_length, o, depth + 1) < 0)
 			return -1;
 
 		last_bit = sig->start_bit + sig->bit_length;
@@ -209,8 +206,9 @@ int dbc2bsm(dbc_t * dbc, FILE * output, bool use_time_stamps)
 	if (use_time_stamps)
 		comment(output, 0, "Generated on: %s", asctime(timeinfo));
 
-	for (size_t i = 0; i < dbc->message_count; i++) {
-		if (msg2bsm(dbc->messages[i], output, 1) < 0) {
+	const compiled_t *c = dbc_compile(dbc);
+	for (size_t i = 0; i < c->message_count; i++) {
+		if (msg2bsm(c, &c->messages[i], output, 1) < 0) {
 			return -1;
 		}
 	}
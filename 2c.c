@@ -12,9 +12,13 @@
 
 #include "2c.h"
 #include "util.h"
+#include "compile.h"
+#include "layout.h"
+#include "fixed.h"
 #include <assert.h>
 #include <ctype.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <string.h>
 #include <time.h>
 
@@ -36,10 +40,39 @@
  * All Exponent Bits Set
  * - Mantissa is zero and sign bit is zero ->  Infinity
  * - Mantissa is zero and sign bit is on   -> -Infinity
- * - Mantissa is non-zero -> NaN */
-
+ * - Mantissa is non-zero -> NaN
+ *
+ * Exponent bits all clear, and a non-zero mantissa -> Denormal, there is no
+ * implicit leading one and the exponent is that of the smallest normal number
+ *
+ * Almost every target uses IEEE-754 for float and double, so the generated
+ * code checks <float.h> and, if they are, copies the bits with memcpy, which
+ * compilers turn into a move between registers. The loops are only used if
+ * the check fails. */
+
+static char *float_ieee754 = "\
+/* float and double are IEEE-754 single and double precision numbers, stored\n\
+ * in the same byte order as integers of the same size, if this is true.\n\
+ * Define DBCC_IEEE754 as 0 to use the (much slower) portable functions. */\n\
+#ifndef DBCC_IEEE754\n\
+#if FLT_RADIX == 2 && FLT_MANT_DIG == 24 && FLT_MAX_EXP == 128 && FLT_MIN_EXP == -125 &&\\\n\
+	DBL_MANT_DIG == 53 && DBL_MAX_EXP == 1024 && DBL_MIN_EXP == -1021\n\
+#define DBCC_IEEE754 (1)\n\
+#else\n\
+#define DBCC_IEEE754 (0)\n\
+#endif\n\
+#endif\n\
+\n\
+#if DBCC_IEEE754\n\
+typedef char dbcc_ieee754_sizes_t[sizeof(float) == 4 && sizeof(double) == 8 ? 1 : -1];\n\
+#endif\n\
+\n";
 
 static char *float_pack = "\
+#if DBCC_IEEE754\n\
+static inline uint32_t pack754_32(const float f)  { uint32_t i = 0; memcpy(&i, &f, sizeof(i)); return i; }\n\
+static inline uint64_t pack754_64(const double f) { uint64_t i = 0; memcpy(&i, &f, sizeof(i)); return i; }\n\
+#else\n\
 /* pack754() -- pack a floating point number into IEEE-754 format */ \n\
 static uint64_t pack754(const double f, const unsigned bits, const unsigned expbits) {\n\
 	if (f == 0.0) /* get this special case out of the way */\n\
@@ -60,15 +93,21 @@ static uint64_t pack754(const double f, const unsigned bits, const unsigned expb
 	int shift = 0;\n\
 	while (fnorm >= 2.0) { fnorm /= 2.0; shift++; }\n\
 	while (fnorm < 1.0)  { fnorm *= 2.0; shift--; }\n\
-	fnorm = fnorm - 1.0;\n\
 \n\
 	const unsigned significandbits = bits - expbits - 1; // -1 for sign bit\n\
+\n\
+	/* get the biased exponent, a denormal has no leading one */\n\
+	long long exp = shift + ((1LL << (expbits - 1)) - 1); // shift + bias\n\
+	if (exp > 0) {\n\
+		fnorm = fnorm - 1.0;\n\
+	} else {\n\
+		for (; exp < 1; exp++)\n\
+			fnorm /= 2.0;\n\
+		exp = 0;\n\
+	}\n\
 \n\
 	/* calculate the binary form (non-float) of the significand data */\n\
 	const long long significand = fnorm * (( 1LL << significandbits) + 0.5f);\n\
-\n\
-	/* get the biased exponent */\n\
-	const long long exp = shift + ((1LL << (expbits - 1)) - 1); // shift + bias\n\
 \n\
 	/* return the final answer */\n\
 	return (sign << (bits - 1)) | (exp << (bits - expbits - 1)) | significand;\n\
@@ -76,12 +115,18 @@ static uint64_t pack754(const double f, const unsigned bits, const unsigned expb
 \n\
 static inline uint32_t   pack754_32(const float  f)   { return   pack754(f, 32, 8); }\n\
 static inline uint64_t   pack754_64(const double f)   { return   pack754(f, 64, 11); }\n\
+#endif\n\
 \n\n";
 
 static char *float_unpack = "\
+#if DBCC_IEEE754\n\
+static inline float  unpack754_32(uint32_t i) { float f = 0;  memcpy(&f, &i, sizeof(f)); return f; }\n\
+static inline double unpack754_64(uint64_t i) { double f = 0; memcpy(&f, &i, sizeof(f)); return f; }\n\
+#else\n\
 /* unpack754() -- unpack a floating point number from IEEE-754 format */ \n\
 static double unpack754(const uint64_t i, const unsigned bits, const unsigned expbits) {\n\
-	if (i == 0) return 0.0;\n\
+	if ((i & ((1uLL << (bits - 1)) - 1uLL)) == 0) /* +/- zero */\n\
+		return (i >> (bits - 1)) & 1 ? -0.0 : 0.0;\n\
 \n\
 	const uint64_t expset = ((1uLL << expbits) - 1uLL) << (bits - expbits - 1);\n\
 	if ((i & expset) == expset) { /* NaN or +/-Infinity */\n\
@@ -94,11 +139,14 @@ static double unpack754(const uint64_t i, const unsigned bits, const unsigned ex
 	const unsigned significandbits = bits - expbits - 1; /* - 1 for sign bit */\n\
 	double result = (i & ((1LL << significandbits) - 1)); /* mask */\n\
 	result /= (1LL << significandbits);  /* convert back to float */\n\
-	result += 1.0f;                        /* add the one back on */\n\
 \n\
-	/* deal with the exponent */\n\
+	/* deal with the exponent, a denormal has no leading one */\n\
 	const unsigned bias = (1 << (expbits - 1)) - 1;\n\
 	long long shift = ((i >> significandbits) & ((1LL << expbits) - 1)) - bias;\n\
+	if (shift == -(long long)bias)\n\
+		shift++;\n\
+	else\n\
+		result += 1.0f;                /* add the one back on */\n\
 	while (shift > 0) { result *= 2.0; shift--; }\n\
 	while (shift < 0) { result /= 2.0; shift++; }\n\
 	\n\
@@ -107,19 +155,13 @@ static double unpack754(const uint64_t i, const unsigned bits, const unsigned ex
 \n\
 static inline float    unpack754_32(uint32_t i) { return unpack754(i, 32, 8); }\n\
 static inline double   unpack754_64(uint64_t i) { return unpack754(i, 64, 11); }\n\
+#endif\n\
 \n\n";
 
 
 
 static const bool swap_motorola = true;
 
-static unsigned fix_start_bit(bool motorola, unsigned start, unsigned siglen)
-{
-	if (motorola)
-		start = (8 * (7 - (start / 8))) + (start % 8) - (siglen - 1);
-	return start;
-}
-
 static const char *determine_unsigned_type(unsigned length)
 {
 	const char *type = "uint64_t";
@@ -167,22 +209,131 @@ static int comment(signal_t *sig, FILE *o, const char *indent)
 			sig->offset) < 0 ? - 1 : 0;
 }
 
-static int signal2deserializer(signal_t *sig, const char *msg_name, FILE *o, const char *indent)
+/* A signal that is whole bytes of the payload, shares them with no other
+ * signal and is as wide as the type it is held in is not masked, storing
+ * it in (or converting it to) that type does the same thing. */
+static bool unmasked(const signal_t *sig)
+{
+	assert(sig);
+	const unsigned whole = LAYOUT_INSIDE | LAYOUT_DISJOINT | LAYOUT_ALIGNED;
+	if ((sig->layout & whole) != whole || sig->is_floating)
+		return false;
+	const unsigned length = sig->bit_length;
+	return length == 8 || length == 16 || length == 32 || length == 64;
+}
+
+/* The bytes of a CAN-FD payload (see compiled_is_fd) a signal occupies,
+ * "first" is the lowest byte, "count" is at most nine, and "shift" is the
+ * right shift of the signal in the bytes once they are loaded in the byte
+ * order of the signal. Motorola signals count their bits from the most
+ * significant bit of the first byte. */
+typedef struct {
+	unsigned first, count, shift;
+} span_t;
+
+static span_t signal_span(const signal_t *sig)
+{
+	assert(sig);
+	assert(sig->bit_length > 0 && sig->bit_length <= 64);
+	span_t r = { .first = sig->start_bit / 8, };
+	if (sig->endianess == endianess_motorola_e) {
+		const unsigned lsb = (r.first * 8) + 7 - (sig->start_bit % 8) + sig->bit_length - 1;
+		r.count = (lsb / 8) - r.first + 1;
+		r.shift = 7 - (lsb % 8);
+	} else {
+		r.count = ((sig->start_bit + sig->bit_length - 1) / 8) - r.first + 1;
+		r.shift = sig->start_bit % 8;
+	}
+	assert(r.count <= 9);
+	return r;
+}
+
+/* Whole 64-bit words are loaded with one memcpy, so a signal in three to
+ * seven bytes is widened to eight if the payload, of "bytes" bytes, has room
+ * for them. One or two bytes are quicker to load on their own. */
+static span_t signal_span_wide(const signal_t *sig, unsigned bytes)
+{
+	assert(sig);
+	span_t r = signal_span(sig);
+	if (r.count < 3 || r.count >= 8 || (r.first + 8) > bytes)
+		return r;
+	if (sig->endianess == endianess_motorola_e)
+		r.shift += (8 - r.count) * 8;
+	r.count = 8;
+	return r;
+}
+
+static int signal2load(signal_t *sig, FILE *o, const char *indent, unsigned bytes)
+{
+	assert(sig);
+	assert(o);
+	assert(indent);
+	const bool motorola = (sig->endianess == endianess_motorola_e);
+	const uint64_t mask = compiled_mask(sig->bit_length);
+	if (sig->bit_length == 0)
+		return fprintf(o, "%sx = 0;\n", indent) < 0 ? -1 : 0;
+	const span_t s = signal_span_wide(sig, bytes);
+	char value[128] = { 0, };
+	/* a signal can straddle nine bytes, the ninth is loaded on its own */
+	if (s.count == 9 && motorola)
+		snprintf(value, sizeof(value), "(dbcc_load_be(&data[%u], 8) << %u) | (data[%u] >> %u)", s.first, 8 - s.shift, s.first + 8, s.shift);
+	else if (s.count == 9)
+		snprintf(value, sizeof(value), "(dbcc_load_le(&data[%u], 8) >> %u) | ((uint64_t)data[%u] << %u)", s.first, s.shift, s.first + 8, 64 - s.shift);
+	else if (s.shift)
+		snprintf(value, sizeof(value), "dbcc_load_%s(&data[%u], %u) >> %u", motorola ? "be" : "le", s.first, s.count, s.shift);
+	else
+		snprintf(value, sizeof(value), "dbcc_load_%s(&data[%u], %u)", motorola ? "be" : "le", s.first, s.count);
+	if (unmasked(sig))
+		return fprintf(o, "%sx = %s;\n", indent, value) < 0 ? -1 : 0;
+	return fprintf(o, "%sx = (%s) & 0x%"PRIx64";\n", indent, value, mask) < 0 ? -1 : 0;
+}
+
+static int signal2store(signal_t *sig, FILE *o, const char *indent)
+{
+	assert(sig);
+	assert(o);
+	assert(indent);
+	if (sig->bit_length == 0)
+		return 0;
+	const span_t s = signal_span(sig);
+	if (sig->endianess == endianess_motorola_e) {
+		if (s.count == 9)
+			return fprintf(o, "%sdbcc_or_be(&data[%u], 8, x >> %u);\n%sdata[%u] |= (uint8_t)(x << %u);\n",
+				indent, s.first, 8 - s.shift, indent, s.first + 8, s.shift) < 0 ? -1 : 0;
+	} else {
+		if (s.count == 9)
+			return fprintf(o, "%sdbcc_or_le(&data[%u], 8, x << %u);\n%sdata[%u] |= (uint8_t)(x >> %u);\n",
+				indent, s.first, s.shift, indent, s.first + 8, 64 - s.shift) < 0 ? -1 : 0;
+	}
+	if (s.shift)
+		return fprintf(o, "%sdbcc_or_%s(&data[%u], %u, x << %u);\n", indent,
+			sig->endianess == endianess_motorola_e ? "be" : "le", s.first, s.count, s.shift) < 0 ? -1 : 0;
+	return fprintf(o, "%sdbcc_or_%s(&data[%u], %u, x);\n", indent,
+		sig->endianess == endianess_motorola_e ? "be" : "le", s.first, s.count) < 0 ? -1 : 0;
+}
+
+/* "bytes" is the payload length of CAN-FD messages, which are unpacked from a
+ * byte buffer instead of from a 64-bit word, it is zero otherwise */
+static int signal2deserializer(signal_t *sig, const char *msg_name, FILE *o, const char *indent, unsigned bytes)
 {
 	assert(sig);
 	assert(msg_name);
 	assert(o);
 	const bool motorola   = (sig->endianess == endianess_motorola_e);
-	const unsigned start  = fix_start_bit(motorola, sig->start_bit, sig->bit_length);
+	const unsigned start  = bytes ? 0 : compiled_shift(motorola, sig->start_bit, sig->bit_length);
 	const unsigned length = sig->bit_length;
-	const uint64_t mask = length == 64 ?
-		0xFFFFFFFFFFFFFFFFuLL :
-		(1uLL << length) - 1uLL;
+	const uint64_t mask = compiled_mask(length);
 
 	if (comment(sig, o, indent) < 0)
 		return -1;
 
-	if (start) {
+	if (bytes) {
+		if (signal2load(sig, o, indent, bytes) < 0)
+			return -1;
+	} else if (unmasked(sig)) {
+		if (fprintf(o, start ? "%sx = %c >> %d;\n" : "%sx = %c;\n", indent, motorola ? 'm' : 'i', start) < 0)
+			return -1;
+	} else if (start) {
 		if (fprintf(o, "%sx = (%c >> %d) & 0x%"PRIx64";\n", indent, motorola ? 'm' : 'i', start, mask) < 0)
 			return -1;
 	} else {
@@ -214,16 +365,14 @@ static int signal2deserializer(signal_t *sig, const char *msg_name, FILE *o, con
 	return fprintf(o, "%so->%s.%s = x;\n", indent, msg_name, sig->name) < 0 ? -1 : 0;
 }
 
-static int signal2serializer(signal_t *sig, const char *msg_name, FILE *o, const char *indent)
+static int signal2serializer(signal_t *sig, const char *msg_name, FILE *o, const char *indent, unsigned bytes)
 {
 	assert(sig);
 	assert(o);
 	bool motorola = (sig->endianess == endianess_motorola_e);
-	int start = fix_start_bit(motorola, sig->start_bit, sig->bit_length);
+	int start = bytes ? 0 : compiled_shift(motorola, sig->start_bit, sig->bit_length);
 
-	uint64_t mask = sig->bit_length == 64 ?
-		0xFFFFFFFFFFFFFFFFuLL :
-		(1uLL << sig->bit_length) - 1uLL;
+	uint64_t mask = compiled_mask(sig->bit_length);
 
 	if (comment(sig, o, indent) < 0)
 		return -1;
@@ -232,10 +381,15 @@ static int signal2serializer(signal_t *sig, const char *msg_name, FILE *o, const
 		assert(sig->bit_length == 32 || sig->bit_length == 64);
 		if (fprintf(o, "%sx = pack754_%u(o->%s.%s) & 0x%"PRIx64";\n", indent, sig->bit_length, msg_name, sig->name, mask) < 0)
 			return -1;
+	} else if (unmasked(sig)) {
+		if (fprintf(o, "%sx = (%s)(o->%s.%s);\n", indent, determine_unsigned_type(sig->bit_length), msg_name, sig->name) < 0)
+			return -1;
 	} else {
 		if (fprintf(o, "%sx = ((%s)(o->%s.%s)) & 0x%"PRIx64";\n", indent, determine_unsigned_type(sig->bit_length), msg_name, sig->name, mask) < 0)
 			return -1;
 	}
+	if (bytes)
+		return signal2store(sig, o, indent);
 	if (start)
 		if (fprintf(o, "%sx <<= %u; \n", indent, start) < 0)
 			return -1;
@@ -315,7 +469,7 @@ static int64_t signed_min(signal_t *sig)
 	return ~signed_max(sig);
 }
 
-static int signal2scaling_encode(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool header, const char *god, dbc2c_options_t *copts)
+static int signal2scaling_encode(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool header, bool merged, const char *god, dbc2c_options_t *copts)
 {
 	assert(msgname);
 	assert(sig);
@@ -324,9 +478,9 @@ static int signal2scaling_encode(const char *msgname, unsigned id, signal_t *sig
 	const char *type = determine_type(sig->bit_length, sig->is_signed, sig->is_floating);
 	if (sig->scaling != 1.0 || sig->offset != 0.0)
 		type = "dbcc_double_t";
-	if (copts->use_id_in_name)
+	if (copts->use_id_in_name && !merged)
 		fprintf(o, "int encode_can_0x%03x_%s(can_obj_%s_t *o, %s in)", id, sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
-	else if (copts->version >= 2)
+	else if (copts->version >= 2 || merged)
 		fprintf(o, "int encode_%s_%s(can_obj_%s_t *o, %s in)", msgname, sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
 	else
 		fprintf(o, "int encode_can_%s(can_obj_%s_t *o, %s in)", sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
@@ -371,7 +525,31 @@ static int signal2scaling_encode(const char *msgname, unsigned id, signal_t *sig
 	return fputs("\treturn 0;\n}\n\n", o);
 }
 
-static int signal2scaling_decode(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool header, const char *god, dbc2c_options_t *copts)
+/* Whether "decode_..." checks a signal against its minimum and its maximum,
+ * a limit the raw value cannot go past is not checked */
+static void signal_range_checks(signal_t *sig, bool *gmin, bool *gmax)
+{
+	assert(sig);
+	assert(gmin);
+	assert(gmax);
+	*gmin = false;
+	*gmax = false;
+	if (!signal_are_min_max_valid(sig))
+		return;
+	if (sig->is_signed) { /**@warning comparison may fail because of limits of double size */
+		*gmin = sig->minimum > signed_min(sig);
+		*gmax = sig->maximum < signed_max(sig);
+	} else {
+		*gmin = sig->minimum > 0.0;
+		*gmax = sig->maximum < unsigned_max(sig);
+	}
+	if (sig->is_floating) {
+		*gmax = true;
+		*gmax = true;
+	}
+}
+
+static int signal2scaling_decode(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool header, bool merged, const char *god, dbc2c_options_t *copts)
 {
 	assert(msgname);
 	assert(sig);
@@ -380,9 +558,9 @@ static int signal2scaling_decode(const char *msgname, unsigned id, signal_t *sig
 	const char *type = determine_type(sig->bit_length, sig->is_signed, sig->is_floating);
 	if (sig->scaling != 1.0 || sig->offset != 0.0)
 		type = "dbcc_double_t";
-	if (copts->use_id_in_name)
+	if (copts->use_id_in_name && !merged)
 		fprintf(o, "int decode_can_0x%03x_%s(const can_obj_%s_t *o, %s *out)", id, sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
-	else if (copts->version >= 2)
+	else if (copts->version >= 2 || merged)
 		fprintf(o, "int decode_%s_%s(const can_obj_%s_t *o, %s *out)", msgname, sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
 	else
 		fprintf(o, "int decode_can_%s(const can_obj_%s_t *o, %s *out)", sig->name, god, copts->use_doubles_for_encoding ? "dbcc_double_t" : type);
@@ -400,43 +578,22 @@ static int signal2scaling_decode(const char *msgname, unsigned id, signal_t *sig
 		fprintf(o, "\trval *= %g;\n", sig->scaling);
 	if (sig->offset != 0.0)
 		fprintf(o, "\trval += %g;\n", sig->offset);
-	if (signal_are_min_max_valid(sig)) {
-		bool gmax = true;
-		bool gmin = true;
-
-		if (sig->is_signed) { /**@warning comparison may fail because of limits of double size */
-			gmin = sig->minimum > signed_min(sig);
-			gmax = sig->maximum < signed_max(sig);
-		} else {
-			gmin = sig->minimum > 0.0;
-			gmax = sig->maximum < unsigned_max(sig);
-		}
-		if (sig->is_floating) {
-			gmax = true;
-			gmax = true;
-		}
-
-		if (!gmax && !gmin) {
-			fputs("\t*out = rval;\n", o);
-			fputs("\treturn 0;\n", o);
-		} else {
-			if (gmin && gmax) {
-				fprintf(o, "\tif ((rval >= %g) && (rval <= %g)) {\n", sig->minimum, sig->maximum);
-			} else if (gmax) {
-				fprintf(o, "\tif (rval <= %g) {\n", sig->maximum);
-			} else if (gmin) {
-				fprintf(o, "\tif (rval >= %g) {\n", sig->minimum);
-			}
-			fputs("\t\t*out = rval;\n", o);
-			fputs("\t\treturn 0;\n", o);
-			fputs("\t} else {\n", o);
-			fprintf(o, "\t\t*out = (%s)0;\n", type);
-			fputs("\t\treturn -1;\n", o);
-			fputs("\t}\n", o);
-
+	bool gmin = false, gmax = false;
+	signal_range_checks(sig, &gmin, &gmax);
+	if (gmin || gmax) {
+		if (gmin && gmax) {
+			fprintf(o, "\tif ((rval >= %g) && (rval <= %g)) {\n", sig->minimum, sig->maximum);
+		} else if (gmax) {
+			fprintf(o, "\tif (rval <= %g) {\n", sig->maximum);
+		} else if (gmin) {
+			fprintf(o, "\tif (rval >= %g) {\n", sig->minimum);
 		}
-
-
+		fputs("\t\t*out = rval;\n", o);
+		fputs("\t\treturn 0;\n", o);
+		fputs("\t} else {\n", o);
+		fprintf(o, "\t\t*out = (%s)0;\n", type);
+		fputs("\t\treturn -1;\n", o);
+		fputs("\t}\n", o);
 	} else {
 		fputs("\t*out = rval;\n", o);
 		fputs("\treturn 0;\n", o);
@@ -444,12 +601,250 @@ static int signal2scaling_decode(const char *msgname, unsigned id, signal_t *sig
 	return fputs("}\n\n", o);
 }
 
-static int signal2scaling(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool decode, bool header, const char *god, dbc2c_options_t *copts)
+/* The same identifier can be on more than one bus in a merged database, so
+ * the functions for its signals are named after the (unique) message. */
+static int signal2scaling(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool decode, bool header, bool merged, const char *god, dbc2c_options_t *copts)
+{
+	assert(copts);
+	if (decode)
+		return signal2scaling_decode(msgname, id, sig, o, header, merged, god, copts);
+	return signal2scaling_encode(msgname, id, sig, o, header, merged, god, copts);
+}
+
+static int signal_function_name(FILE *o, const char *prefix, const char *msgname, unsigned id, const signal_t *sig, bool merged, dbc2c_options_t *copts);
+
+/* Integer only versions of "decode_..." and "encode_..." that work in units
+ * of 1/"fixed_point" of the physical value, see fixed.h. The header says how
+ * each signal is scaled and how far out a value can be, or why it has no
+ * such functions. */
+static bool signal_fixed(signal_t *sig, fixed_t *f, const char **why, dbc2c_options_t *copts)
+{
+	assert(sig);
+	assert(f);
+	assert(why);
+	assert(copts);
+	bool gmin = false, gmax = false;
+	signal_range_checks(sig, &gmin, &gmax);
+	return fixed_signal(sig, copts->fixed_point, gmin, gmax, f, why);
+}
+
+static int signal2fixed_report(const char *msgname, signal_t *sig, FILE *h, dbc2c_options_t *copts)
+{
+	assert(msgname);
+	assert(sig);
+	assert(h);
+	assert(copts);
+	fixed_t f;
+	const char *why = NULL;
+	if (!signal_fixed(sig, &f, &why, copts)) {
+		note("signal '%s' of message '%s' has no fixed point functions as %s", sig->name, msgname, why);
+		return fprintf(h, "/* %s has no fixed point functions as %s */\n", sig->name, why) < 0 ? -1 : 0;
+	}
+	/* an exact signal is only out by the rounding, so is of little note */
+	(f.exact ? debug : note)("signal '%s' of message '%s': scaling %"PRId64"/%"PRId64", offset %"PRId64"/%"PRId64"%s, error at most %g units",
+		sig->name, msgname, f.scaling[0], f.scaling[1], f.offset[0], f.offset[1], f.exact ? "" : " (approximate)", f.error);
+	return fprintf(h, "/* %s in units of 1/%"PRIu64": scaling %"PRId64"/%"PRId64", offset %"PRId64"/%"PRId64"%s, error at most %g units */\n",
+		sig->name, copts->fixed_point, f.scaling[0], f.scaling[1], f.offset[0], f.offset[1], f.exact ? "" : " (approximate)", f.error) < 0 ? -1 : 0;
+}
+
+/* "op" is "*", "+" or "-", a negative constant flips the sign of the last two */
+static void fixed_constant(FILE *o, const char *op, int64_t c)
+{
+	assert(o);
+	assert(op);
+	if (c < 0 && *op != '*')
+		fprintf(o, " %c %"PRId64, *op == '+' ? '-' : '+', -c);
+	else
+		fprintf(o, " %s %"PRId64, op, c);
+}
+
+static int signal2fixed(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool decode, bool header, bool merged, const char *god, dbc2c_options_t *copts)
 {
+	assert(msgname);
+	assert(sig);
+	assert(o);
+	assert(god);
 	assert(copts);
+	fixed_t f;
+	const char *why = NULL;
+	if (!signal_fixed(sig, &f, &why, copts))
+		return 0;
+	const char *value = f.value_wide ? "int64_t" : "int32_t";
+	const char *wide = (decode ? f.wide : f.ewide) ? "int64_t" : "int32_t";
+	const char *div = (decode ? f.wide : f.ewide) ? "dbcc_div64" : "dbcc_div32";
+	fputs("int ", o);
+	signal_function_name(o, decode ? "decode_fixed" : "encode_fixed", msgname, id, sig, merged, copts);
 	if (decode)
-		return signal2scaling_decode(msgname, id, sig, o, header, god, copts);
-	return signal2scaling_encode(msgname, id, sig, o, header, god, copts);
+		fprintf(o, "(const can_obj_%s_t *o, %s *out)", god, value);
+	else
+		fprintf(o, "(can_obj_%s_t *o, %s in)", god, value);
+	if (header)
+		return fputs(";\n", o) < 0 ? -1 : 0;
+	fputs(" {\n", o);
+	if (copts->generate_asserts)
+		fputs(decode ? "\tassert(o);\n\tassert(out);\n" : "\tassert(o);\n", o);
+	if (decode) {
+		fprintf(o, "\tconst %s n = (%s)o->%s.%s", wide, wide, msgname, sig->name);
+		if (f.mul != 1)
+			fixed_constant(o, "*", f.mul);
+		if (f.add)
+			fixed_constant(o, "+", f.add);
+		fputs(";\n", o);
+		if (f.has_lo || f.has_hi) {
+			fputs("\tif (", o);
+			if (f.has_lo)
+				fprintf(o, "(n < %"PRId64")%s", f.lo, f.has_hi ? " || " : "");
+			if (f.has_hi)
+				fprintf(o, "(n > %"PRId64")", f.hi);
+			fputs(") {\n\t\t*out = 0;\n\t\treturn -1;\n\t}\n", o);
+		}
+		if (f.div == 1)
+			fprintf(o, "\t*out = n;\n");
+		else
+			fprintf(o, "\t*out = %s(n, %"PRId64");\n", div, f.div);
+		return fputs("\treturn 0;\n}\n\n", o) < 0 ? -1 : 0;
+	}
+	/* the raw value can only be out of range if a value rounds to one */
+	const int64_t r0 = fixed_rounded(f.vlo * f.emul - f.eadd, f.ediv), r1 = fixed_rounded(f.vhi * f.emul - f.eadd, f.ediv);
+	const bool check = r0 < f.rlo || r0 > f.rhi || r1 < f.rlo || r1 > f.rhi;
+	fprintf(o, "\tif ((in < %"PRId64") || (in > %"PRId64")) {\n\t\to->%s.%s = 0;\n\t\treturn -1;\n\t}\n", f.vlo, f.vhi, msgname, sig->name);
+	if (strcmp(wide, value))
+		fprintf(o, "\tconst %s n = (%s)in", wide, wide);
+	else
+		fprintf(o, "\tconst %s n = in", wide);
+	if (f.emul != 1)
+		fixed_constant(o, "*", f.emul);
+	if (f.eadd)
+		fixed_constant(o, "-", f.eadd);
+	fputs(";\n", o);
+	if (f.ediv == 1)
+		fprintf(o, "\tconst %s raw = n;\n", wide);
+	else
+		fprintf(o, "\tconst %s raw = %s(n, %"PRId64");\n", wide, div, f.ediv);
+	if (check)
+		fprintf(o, "\tif ((raw < %"PRId64") || (raw > %"PRId64")) {\n\t\to->%s.%s = 0;\n\t\treturn -1;\n\t}\n", f.rlo, f.rhi, msgname, sig->name);
+	fprintf(o, "\to->%s.%s = (%s)raw;\n", msgname, sig->name, determine_type(sig->bit_length, sig->is_signed, false));
+	return fputs("\treturn 0;\n}\n\n", o) < 0 ? -1 : 0;
+}
+
+static bool signal_has_fixed(const signal_t *sig, dbc2c_options_t *copts)
+{
+	assert(sig);
+	assert(copts);
+	return copts->fixed_point && !sig->is_floating;
+}
+
+static int signal_function_name(FILE *o, const char *prefix, const char *msgname, unsigned id, const signal_t *sig, bool merged, dbc2c_options_t *copts)
+{
+	assert(o);
+	assert(prefix);
+	assert(msgname);
+	assert(sig);
+	assert(copts);
+	if (copts->use_id_in_name && !merged)
+		return fprintf(o, "%s_can_0x%03x_%s", prefix, id, sig->name);
+	if (copts->version >= 2 || merged)
+		return fprintf(o, "%s_%s_%s", prefix, msgname, sig->name);
+	return fprintf(o, "%s_can_%s", prefix, sig->name);
+}
+
+/* The type "decode_..." gives a signal */
+static const char *signal_decode_type(const signal_t *sig, dbc2c_options_t *copts)
+{
+	assert(sig);
+	assert(copts);
+	if (copts->use_doubles_for_encoding || sig->scaling != 1.0 || sig->offset != 0.0)
+		return "dbcc_double_t";
+	return determine_type(sig->bit_length, sig->is_signed, sig->is_floating);
+}
+
+/* Decodes a signal from the 64-bit word "word", which has been byte swapped
+ * for motorola signals, into the lvalue "dest" without a branch. The
+ * arithmetic is done in 32 bits where it can be as few instruction sets can
+ * convert 64-bit integers to floating point a vector at a time. The scaling
+ * is done in the same order as "decode_..." so the results are the same,
+ * there is no range check nor a check of the multiplexor. */
+static int signal2value(signal_t *sig, FILE *o, const char *indent, const char *word, const char *dest, dbc2c_options_t *copts)
+{
+	assert(sig);
+	assert(o);
+	assert(indent);
+	assert(word);
+	assert(dest);
+	assert(copts);
+	const unsigned length = sig->bit_length;
+	const bool motorola   = sig->endianess == endianess_motorola_e;
+	const unsigned start  = compiled_shift(motorola, sig->start_bit, length);
+	const bool scaled     = sig->scaling != 1.0 || sig->offset != 0.0;
+	const bool narrow     = length <= 32 && !sig->is_floating;
+	const char *type      = signal_decode_type(sig, copts);
+	char value[64] = { 0, };
+	if (comment(sig, o, indent) < 0)
+		return -1;
+	if (start)
+		snprintf(value, sizeof(value), "(%s >> %u)", word, start);
+	else
+		snprintf(value, sizeof(value), "%s", word);
+	if (length == 64)
+		fprintf(o, "%sconst uint64_t x = %s;\n", indent, value);
+	else if (length == 32 && narrow)
+		fprintf(o, "%sconst uint32_t x = (uint32_t)%s;\n", indent, value);
+	else if (narrow)
+		fprintf(o, "%sconst uint32_t x = (uint32_t)%s & 0x%"PRIx64"u;\n", indent, value, compiled_mask(length));
+	else
+		fprintf(o, "%sconst uint64_t x = %s & 0x%"PRIx64"u;\n", indent, value, compiled_mask(length));
+	/* sign extension without a branch, flipping the sign bit then taking it
+	 * away again borrows from all of the bits above it if it was set */
+	const char *v = "x";
+	if (sig->is_floating) {
+		v = length == 64 ? "unpack754_64(x)" : "unpack754_32((uint32_t)x)";
+	} else if (sig->is_signed && (length == 32 || length == 64)) {
+		fprintf(o, "%sconst %s v = (%s)x;\n", indent, narrow ? "int32_t" : "int64_t", narrow ? "int32_t" : "int64_t");
+		v = "v";
+	} else if (sig->is_signed) {
+		fprintf(o, "%sconst %s v = (%s)((x ^ 0x%"PRIx64"u) - 0x%"PRIx64"u);\n", indent,
+			narrow ? "int32_t" : "int64_t", narrow ? "int32_t" : "int64_t", (uint64_t)1 << (length - 1), (uint64_t)1 << (length - 1));
+		v = "v";
+	} else if (narrow && length < 32 && strcmp(type, "dbcc_double_t") == 0) {
+		v = "(int32_t)x"; /* positive, and a quicker conversion */
+	}
+	if (sig->scaling == 0.0)
+		error("invalid scaling factor (fix your DBC file)");
+	if (!scaled)
+		return fprintf(o, "%s%s = (%s)%s;\n", indent, dest, type, v) < 0 ? -1 : 0;
+	fprintf(o, "%s%s r = (%s)%s;\n", indent, type, type, v);
+	if (sig->scaling != 1.0)
+		fprintf(o, "%sr *= %g;\n", indent, sig->scaling);
+	if (sig->offset != 0.0)
+		fprintf(o, "%sr += %g;\n", indent, sig->offset);
+	return fprintf(o, "%s%s = r;\n", indent, dest) < 0 ? -1 : 0;
+}
+
+/* Decodes one signal from "n" payloads, each the 64-bit word that would be
+ * passed to "unpack_message", into the type "decode_..." gives it. The loop
+ * has no branches so that the compiler can vectorize it, see DBCC_VECTORIZE. */
+static int signal2extract(const char *msgname, unsigned id, signal_t *sig, FILE *o, bool header, bool merged, dbc2c_options_t *copts)
+{
+	assert(msgname);
+	assert(sig);
+	assert(o);
+	assert(copts);
+	assert(!sig->is_floating);
+	const char *type = signal_decode_type(sig, copts);
+	if (!header)
+		fputs("DBCC_VECTORIZE\n", o);
+	fputs("void ", o);
+	signal_function_name(o, "extract", msgname, id, sig, merged, copts);
+	if (header)
+		return fprintf(o, "(const uint64_t *data, size_t n, %s *out);\n", type) < 0 ? -1 : 0;
+	fprintf(o, "(const uint64_t *restrict data, size_t n, %s *restrict out) {\n", type);
+	if (copts->generate_asserts)
+		fputs("\tassert(data || n == 0);\n\tassert(out || n == 0);\n", o);
+	fputs("\tfor (size_t k = 0; k < n; k++) {\n", o);
+	const bool motorola = sig->endianess == endianess_motorola_e;
+	if (signal2value(sig, o, "\t\t", motorola ? "reverse_byte_order(data[k])" : "data[k]", "out[k]", copts) < 0)
+		return -1;
+	return fputs("\t}\n}\n\n", o) < 0 ? -1 : 0;
 }
 
 static int print_function_name(FILE *out, const char *prefix, const char *name, const char *postfix, bool in, char *datatype, bool dlc, const char *god)
@@ -477,26 +872,12 @@ static void make_name(char *newname, size_t maxlen, const char *name, unsigned i
 		snprintf(newname, maxlen-1, "can_%s", name);
 }
 
-static signal_t *find_multiplexor(can_msg_t *msg) {
-	assert(msg);
-	signal_t *multiplexor = NULL;
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *sig = msg->sigs[i];
-		if (sig->is_multiplexor) {
-			multiplexor = sig;
-		}
-		if (sig->is_multiplexed)
-			continue;
-	}
-	return multiplexor;
-}
-
-static void recursively_process_multiplexed(signal_t *sig, FILE *c, const char *name, bool serialize, size_t indent_level) {
+static void recursively_process_multiplexed(signal_t *sig, FILE *c, const char *name, bool serialize, unsigned bytes, size_t indent_level) {
 	char* indent = malloc((indent_level + 1) * sizeof(char));
 	memset(indent, '\t', indent_level);
 	indent[indent_level] = '\0';
 
-	if ((serialize ? signal2serializer(sig, name, c, indent) : signal2deserializer(sig, name, c, indent)) < 0) {
+	if ((serialize ? signal2serializer(sig, name, c, indent, bytes) : signal2deserializer(sig, name, c, indent, bytes)) < 0) {
 		error("%s failed", serialize ? "serialization" : "deserialization");
 	}
 
@@ -512,7 +893,7 @@ static void recursively_process_multiplexed(signal_t *sig, FILE *c, const char *
 		} else {
 			fprintf(c, "if (o->%s.%s >= %u && o->%s.%s <= %u) {\n", name, sig->name, mul_val->min_value, name, sig->name, mul_val->max_value);
 		}
-		recursively_process_multiplexed(sig->muxed[i], c, name, serialize, indent_level + 1);
+		recursively_process_multiplexed(sig->muxed[i], c, name, serialize, bytes, indent_level + 1);
 	}
 
 	if(sig->mul_num != 0) {
@@ -522,7 +903,7 @@ static void recursively_process_multiplexed(signal_t *sig, FILE *c, const char *
 	free(indent);
 }
 
-static signal_t *process_signals_and_find_multiplexer(can_msg_t *msg, FILE *c, const char *name, bool serialize)
+static signal_t *process_signals_and_find_multiplexer(can_msg_t *msg, FILE *c, const char *name, bool serialize, unsigned bytes)
 {
 	assert(msg);
 	assert(c);
@@ -534,14 +915,14 @@ static signal_t *process_signals_and_find_multiplexer(can_msg_t *msg, FILE *c, c
 		if (sig->is_multiplexed)
 			continue;
 		if (sig->muxed) {
-			recursively_process_multiplexed(sig, c, name, serialize, 1);
+			recursively_process_multiplexed(sig, c, name, serialize, bytes, 1);
 			continue;
 		} else if (sig->is_multiplexor) {
 			if (multiplexor)
 				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", name);
 			multiplexor = sig;
 		}
-		if ((serialize ? signal2serializer(sig, name, c, "\t") : signal2deserializer(sig, name, c, "\t")) < 0)
+		if ((serialize ? signal2serializer(sig, name, c, "\t", bytes) : signal2deserializer(sig, name, c, "\t", bytes)) < 0)
 			error("%s failed", serialize ? "serialization" : "deserialization");
 	}
 	return multiplexor;
@@ -558,7 +939,7 @@ static int cmp_signal(const void *lhs, const void *rhs)
 		ret = 1;
 	return ret;
 }
-static int multiplexor_switch(can_msg_t *msg, signal_t *multiplexor, FILE *c, const char *msg_name, bool serialize)
+static int multiplexor_switch(can_msg_t *msg, signal_t *multiplexor, FILE *c, const char *msg_name, bool serialize, unsigned bytes)
 {
 	assert(msg);
 	assert(multiplexor);
@@ -574,7 +955,7 @@ static int multiplexor_switch(can_msg_t *msg, signal_t *multiplexor, FILE *c, co
 		for (; j < msg->signal_count && msg->sigs[i]->switchval == msg->sigs[j]->switchval; j++) {
 			assert(j < msg->signal_count);
 			signal_t* sig = msg->sigs[j];
-			if ((serialize ? signal2serializer(sig, msg_name, c, "\t\t") : signal2deserializer(sig, msg_name, c, "\t\t")) < 0)
+			if ((serialize ? signal2serializer(sig, msg_name, c, "\t\t", bytes) : signal2deserializer(sig, msg_name, c, "\t\t", bytes)) < 0)
 				return -1;
 		}
 		i = j - 1;
@@ -636,10 +1017,10 @@ static int msg_pack(can_msg_t *msg, FILE *c, const char *name, bool motorola_use
 		fprintf(c, "\tregister uint64_t i = 0;\n");
 	if (!message_has_signals)
 		fprintf(c, "\tUNUSED(o);\n\tUNUSED(data);\n");
-	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, true);
+	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, true, 0);
 
 	if (multiplexor)
-		if (multiplexor_switch(msg, multiplexor, c, name, true) < 0)
+		if (multiplexor_switch(msg, multiplexor, c, name, true, 0) < 0)
 			return -1;
 
 	if (message_has_signals) {
@@ -680,9 +1061,83 @@ static int msg_unpack(can_msg_t *msg, FILE *c, const char *name, bool motorola_u
 	else
 		fprintf(c, "\tUNUSED(dlc);\n");
 
-	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, false);
+	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, false, 0);
+	if (multiplexor)
+		if (multiplexor_switch(msg, multiplexor, c, name, false, 0) < 0)
+			return -1;
+	fprintf(c, "\to->%s_rx = 1;\n", name);
+	fprintf(c, "\to->%s_time_stamp_rx = time_stamp;\n", name);
+	fprintf(c, "\treturn %d;\n}\n\n", msg->dlc);
+	return 0;
+}
+
+/* The number of bytes a CAN-FD message needs, which is its DLC unless it
+ * has signals beyond that (which layout_message warns about). */
+static unsigned msg_fd_length(const can_msg_t *msg)
+{
+	assert(msg);
+	unsigned r = msg->dlc < LAYOUT_BYTES ? msg->dlc : LAYOUT_BYTES;
+	for (unsigned b = r; msg->layout && b < LAYOUT_BYTES; b++)
+		if (msg->layout->used[b])
+			r = b + 1;
+	for (size_t i = 0; i < msg->signal_count; i++) {
+		uint8_t bits[LAYOUT_BYTES] = { 0, };
+		signal_t *sig = msg->sigs[i];
+		if (!layout_signal_bits(sig, bits))
+			error("signal '%s' of message '%s' does not fit in a CAN-FD message of %u bytes", sig->name, msg->name, CAN_FD_MAX_DLC);
+	}
+	return r;
+}
+
+static int msg_pack_fd(can_msg_t *msg, FILE *c, const char *name, const char *god, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(c);
+	assert(name);
+	assert(copts);
+	const unsigned length = msg_fd_length(msg);
+	fprintf(c, "static int pack_%s(can_obj_%s_t *o, uint8_t *data) {\n", name, god);
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(o);\n");
+		fprintf(c, "\tassert(data);\n");
+	}
+	if (msg->signal_count)
+		fprintf(c, "\tregister uint64_t x;\n");
+	else
+		fprintf(c, "\tUNUSED(o);\n");
+	fprintf(c, "\tmemset(data, 0, %u);\n", length);
+	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, true, length);
+	if (multiplexor)
+		if (multiplexor_switch(msg, multiplexor, c, name, true, length) < 0)
+			return -1;
+	fprintf(c, "\to->%s_tx = 1;\n", name);
+	fprintf(c, "\treturn %d;\n}\n\n", msg->dlc);
+	return 0;
+}
+
+static int msg_unpack_fd(can_msg_t *msg, FILE *c, const char *name, const char *god, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(c);
+	assert(name);
+	assert(copts);
+	const unsigned length = msg_fd_length(msg);
+	fprintf(c, "static int unpack_%s(can_obj_%s_t *o, const uint8_t *data, uint8_t length, dbcc_time_stamp_t time_stamp) {\n", name, god);
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(o);\n");
+		fprintf(c, "\tassert(length <= %u);\n", CAN_FD_MAX_DLC);
+	}
+	if (msg->signal_count)
+		fprintf(c, "\tregister uint64_t x;\n");
+	else
+		fprintf(c, "\tUNUSED(o);\n\tUNUSED(data);\n");
+	if (length)
+		fprintf(c, "\tif (length < %u)\n\t\treturn -1;\n", length);
+	else
+		fprintf(c, "\tUNUSED(length);\n");
+	signal_t *multiplexor = process_signals_and_find_multiplexer(msg, c, name, false, length);
 	if (multiplexor)
-		if (multiplexor_switch(msg, multiplexor, c, name, false) < 0)
+		if (multiplexor_switch(msg, multiplexor, c, name, false, length) < 0)
 			return -1;
 	fprintf(c, "\to->%s_rx = 1;\n", name);
 	fprintf(c, "\to->%s_time_stamp_rx = time_stamp;\n", name);
@@ -715,69 +1170,349 @@ static int msg_print(can_msg_t *msg, FILE *c, const char *name, const char *god,
 	return msg->signal_count ? fprintf(c, "\treturn r;\n}\n\n") : fprintf(c, "\treturn 0;\n}\n\n");
 }
 
-static int msg_dlc_check(can_msg_t *msg) {
+/* CAN-FD messages do not fit in the 64-bit word "extract_..." takes and the
+ * floating point signals are not a shift and a mask of it */
+static bool signal_has_extract(const can_msg_t *msg, const signal_t *sig, dbc2c_options_t *copts)
+{
 	assert(msg);
-	const unsigned bits = msg->dlc * 8;
-	unsigned used = 0;
-	if (find_multiplexor(msg)) // skip multiplexed messages for now
-		return 0;
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *s = msg->sigs[i];
-		used += s->bit_length;
-	}
-	if (used > bits) {
-		warning("Too many signals, not enough bytes (DLC is too low, fix your DBC file): %s", msg->name);
-		return -1;
-	}
-	return 0;
+	assert(sig);
+	assert(copts);
+	return copts->generate_extract && copts->generate_unpack && !compiled_is_fd(msg) && !sig->is_floating && sig->bit_length > 0;
+}
+
+/* Analysis of a log wants the values of each signal of a message in an array
+ * rather than the latest value of each in a structure, each classic message
+ * can have a set of columns, arrays of the time stamp and of the value of
+ * each signal (as "decode_..." gives it) with a row for each frame. Rows
+ * are only ever appended, the arrays grow as needed. As for "extract_..."
+ * the range of a signal is not checked and every signal is decoded whatever
+ * the value of its multiplexor, which has its own column to filter on. */
+static bool msg_has_columns(const can_msg_t *msg, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(copts);
+	return copts->generate_columns && copts->generate_unpack && !compiled_is_fd(msg);
+}
+
+static int msg2h_columns_type(can_msg_t *msg, FILE *h, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(h);
+	assert(copts);
+	char name[MAX_NAME_LENGTH] = {0};
+	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+	fprintf(h, "typedef struct {\n");
+	fprintf(h, "\tsize_t count, capacity; /* rows used, rows allocated */\n");
+	fprintf(h, "\tdbcc_time_stamp_t *time_stamp;\n");
+	for (size_t i = 0; i < msg->signal_count; i++)
+		fprintf(h, "\t%s *%s;\n", signal_decode_type(msg->sigs[i], copts), msg->sigs[i]->name);
+	return fprintf(h, "} %s_columns_t;\n\n", name) < 0 ? -1 : 0;
 }
 
-static int msg2c(can_msg_t *msg, FILE *c, dbc2c_options_t *copts, char *god)
+static int msg2h_columns(can_msg_t *msg, FILE *h, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(h);
+	assert(copts);
+	char name[MAX_NAME_LENGTH] = {0};
+	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+	fprintf(h, "int reserve_columns_%s(%s_columns_t *c, size_t capacity);\n", name, name);
+	fprintf(h, "int unpack_columns_%s(%s_columns_t *c, uint64_t data, uint8_t dlc, dbcc_time_stamp_t time_stamp);\n", name, name);
+	return fprintf(h, "void free_columns_%s(%s_columns_t *c);\n", name, name) < 0 ? -1 : 0;
+}
+
+static int msg2c_columns(can_msg_t *msg, FILE *c, dbc2c_options_t *copts)
 {
 	assert(msg);
 	assert(c);
 	assert(copts);
-	assert(god);
 	char name[MAX_NAME_LENGTH] = {0};
 	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
-	bool motorola_used = false;
-	bool intel_used = false;
 
+	/* a column that fails to grow is left as it was, columns that have
+	 * grown are bigger than they need to be, which does no harm */
+	fprintf(c, "int reserve_columns_%s(%s_columns_t *c, size_t capacity) {\n", name, name);
+	if (copts->generate_asserts)
+		fprintf(c, "\tassert(c);\n");
+	fprintf(c, "\tvoid *p = NULL;\n");
+	fprintf(c, "\tif (capacity <= c->capacity)\n\t\treturn 0;\n");
+	fprintf(c, "\tif (capacity > (SIZE_MAX / 8))\n\t\treturn -1;\n");
+	fprintf(c, "\tif (!(p = DBCC_REALLOC(c->time_stamp, capacity * sizeof(*c->time_stamp))))\n\t\treturn -1;\n");
+	fprintf(c, "\tc->time_stamp = p;\n");
+	for (size_t i = 0; i < msg->signal_count; i++) {
+		const char *sig = msg->sigs[i]->name;
+		fprintf(c, "\tif (!(p = DBCC_REALLOC(c->%s, capacity * sizeof(*c->%s))))\n\t\treturn -1;\n", sig, sig);
+		fprintf(c, "\tc->%s = p;\n", sig);
+	}
+	fprintf(c, "\tc->capacity = capacity;\n\treturn 0;\n}\n\n");
+
+	bool motorola_used = false, intel_used = false;
 	for (size_t i = 0; i < msg->signal_count; i++)
 		if (msg->sigs[i]->endianess == endianess_motorola_e)
 			motorola_used = true;
 		else
 			intel_used = true;
+	fprintf(c, "int unpack_columns_%s(%s_columns_t *c, uint64_t data, uint8_t dlc, dbcc_time_stamp_t time_stamp) {\n", name, name);
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(c);\n");
+		fprintf(c, "\tassert(dlc <= 8);\n");
+	}
+	if (motorola_used)
+		fprintf(c, "\tconst uint64_t m = reverse_byte_order(data);\n");
+	if (intel_used)
+		fprintf(c, "\tconst uint64_t i = data;\n");
+	if (!motorola_used && !intel_used)
+		fprintf(c, "\tUNUSED(data);\n");
+	if (msg->dlc)
+		fprintf(c, "\tif (dlc < %u)\n\t\treturn -1;\n", msg->dlc);
+	else
+		fprintf(c, "\tUNUSED(dlc);\n");
+	fprintf(c, "\tif (c->count == c->capacity && reserve_columns_%s(c, c->capacity ? c->capacity * 2 : 64) < 0)\n\t\treturn -1;\n", name);
+	fprintf(c, "\tconst size_t row = c->count++;\n");
+	fprintf(c, "\tc->time_stamp[row] = time_stamp;\n");
+	for (size_t i = 0; i < msg->signal_count; i++) {
+		signal_t *sig = msg->sigs[i];
+		char dest[MAX_NAME_LENGTH + 16] = { 0, };
+		snprintf(dest, sizeof(dest), "c->%s[row]", sig->name);
+		fprintf(c, "\t{\n");
+		if (signal2value(sig, c, "\t\t", sig->endianess == endianess_motorola_e ? "m" : "i", dest, copts) < 0)
+			return -1;
+		fprintf(c, "\t}\n");
+	}
+	fprintf(c, "\treturn %u;\n}\n\n", msg->dlc);
 
-	/* sanity checks against messages should go here, we could check for;
-	 * - odd min/max values given scaling
-	 * - duplicate signals and messages
-	 * They really should go into a semantic analysis phase after reading
-	 * in the DBC file and parsing it. Oh Well. */
-	msg_dlc_check(msg);
-
-	if (copts->generate_pack && msg_pack(msg, c, name, motorola_used, intel_used, god, copts) < 0)
-		return -1;
+	fprintf(c, "void free_columns_%s(%s_columns_t *c) {\n", name, name);
+	if (copts->generate_asserts)
+		fprintf(c, "\tassert(c);\n");
+	fprintf(c, "\tDBCC_FREE(c->time_stamp);\n");
+	for (size_t i = 0; i < msg->signal_count; i++)
+		fprintf(c, "\tDBCC_FREE(c->%s);\n", msg->sigs[i]->name);
+	return fprintf(c, "\tmemset(c, 0, sizeof(*c));\n}\n\n") < 0 ? -1 : 0;
+}
 
-	if (copts->generate_unpack && msg_unpack(msg, c, name, motorola_used, intel_used, god, copts) < 0)
-		return -1;
+/* The physical value of every signal of a message in one pass, as calling
+ * "unpack_message" and then "decode_..." for each signal would give them, but
+ * as a float or a double (see dbc2c_physical_e). A bit is set in "valid" for
+ * each signal that is in range and, if it is multiplexed, is selected by its
+ * multiplexor, the value of any other signal is zero. The mask is at most 64
+ * bits so a message with more signals than that does not have the function. */
+static bool msg_has_physical(const can_msg_t *msg, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(copts);
+	return copts->physical != DBC2C_PHYSICAL_NONE && copts->generate_unpack && !compiled_is_fd(msg) && msg->signal_count <= 64;
+}
+
+static int msg2h_physical(can_msg_t *msg, FILE *h, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(h);
+	assert(copts);
+	char name[MAX_NAME_LENGTH] = {0};
+	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+	const size_t n = msg->signal_count;
+	fprintf(h, "typedef struct {\n");
+	for (size_t i = 0; i < n; i++)
+		fprintf(h, "\t%s %s;\n", copts->physical == DBC2C_PHYSICAL_FLOAT ? "float" : "double", msg->sigs[i]->name);
+	fprintf(h, "\t%s valid; /* PHYSICAL_VALID_%s_... */\n", n <= 8 ? "uint8_t" : n <= 16 ? "uint16_t" : n <= 32 ? "uint32_t" : "uint64_t", name);
+	fprintf(h, "} %s_physical_t;\n\n", name);
+	for (size_t i = 0; i < n; i++)
+		fprintf(h, "#define PHYSICAL_VALID_%s_%s (%s(1) << %zu)\n", name, msg->sigs[i]->name, n <= 32 ? "UINT32_C" : "UINT64_C", i);
+	return fprintf(h, "int unpack_physical_%s(%s_physical_t *p, uint64_t data, uint8_t dlc);\n", name, name) < 0 ? -1 : 0;
+}
+
+/* Appends the condition for the multiplexor of signal "i" to select it, and
+ * for its multiplexor to be selected in turn, marking each multiplexor whose
+ * raw value is needed in "raw". The walk is bounded in case they form a loop. */
+static void physical_selected(const can_msg_t *msg, size_t i, bool *raw, char *cond, size_t length)
+{
+	assert(msg);
+	assert(raw);
+	assert(cond);
+	size_t top = SIZE_MAX;
+	for (size_t j = 0; j < msg->signal_count; j++)
+		if (msg->sigs[j]->is_multiplexor && !msg->sigs[j]->is_multiplexed && top == SIZE_MAX)
+			top = j;
+	for (size_t depth = 0; depth < msg->signal_count; depth++) {
+		const signal_t *sig = msg->sigs[i];
+		size_t parent = SIZE_MAX;
+		char term[96] = { 0, };
+		for (size_t j = 0; j < msg->signal_count && parent == SIZE_MAX; j++) {
+			for (size_t k = 0; k < msg->sigs[j]->mul_num; k++) {
+				if (msg->sigs[j]->muxed[k] != sig || j == i)
+					continue;
+				const mul_val_list_t *range = msg->sigs[j]->mux_vals[k];
+				if (range->min_value == range->max_value)
+					snprintf(term, sizeof(term), "(mux_%zu == %uu)", j, range->min_value);
+				else if (range->min_value == 0)
+					snprintf(term, sizeof(term), "(mux_%zu <= %uu)", j, range->max_value);
+				else
+					snprintf(term, sizeof(term), "(mux_%zu >= %uu && mux_%zu <= %uu)", j, range->min_value, j, range->max_value);
+				parent = j;
+				break;
+			}
+		}
+		if (parent == SIZE_MAX && sig->is_multiplexed && top != SIZE_MAX && top != i) {
+			snprintf(term, sizeof(term), "(mux_%zu == %uu)", top, sig->switchval);
+			parent = top;
+		}
+		if (parent == SIZE_MAX)
+			return;
+		raw[parent] = true;
+		if (cond[0])
+			strncat(cond, " && ", length - strlen(cond) - 1);
+		strncat(cond, term, length - strlen(cond) - 1);
+		i = parent;
+	}
+}
+
+static int msg2c_physical(can_msg_t *msg, FILE *c, dbc2c_options_t *copts)
+{
+	assert(msg);
+	assert(c);
+	assert(copts);
+	char name[MAX_NAME_LENGTH] = {0};
+	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+	const size_t n = msg->signal_count;
+	const char *type = copts->physical == DBC2C_PHYSICAL_FLOAT ? "float" : "double";
+	const size_t length = 1024;
+	bool *raw = allocate((n + 1) * sizeof(*raw));
+	char *selected = allocate((n + 1) * length);
+	bool motorola_used = false, intel_used = false;
+	for (size_t i = 0; i < n; i++) {
+		physical_selected(msg, i, raw, &selected[i * length], length);
+		if (msg->sigs[i]->endianess == endianess_motorola_e)
+			motorola_used = true;
+		else
+			intel_used = true;
+	}
+
+	fprintf(c, "int unpack_physical_%s(%s_physical_t *p, uint64_t data, uint8_t dlc) {\n", name, name);
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(p);\n");
+		fprintf(c, "\tassert(dlc <= 8);\n");
+	}
+	if (motorola_used)
+		fprintf(c, "\tconst uint64_t m = reverse_byte_order(data);\n");
+	if (intel_used)
+		fprintf(c, "\tconst uint64_t i = data;\n");
+	if (!motorola_used && !intel_used)
+		fprintf(c, "\tUNUSED(data);\n");
+	if (msg->dlc)
+		fprintf(c, "\tif (dlc < %u)\n\t\treturn -1;\n", msg->dlc);
+	else
+		fprintf(c, "\tUNUSED(dlc);\n");
+	for (size_t i = 0; i < n; i++) {
+		if (!raw[i])
+			continue;
+		const signal_t *sig = msg->sigs[i];
+		const bool motorola = sig->endianess == endianess_motorola_e;
+		const unsigned shift = compiled_shift(motorola, sig->start_bit, sig->bit_length);
+		if (shift)
+			fprintf(c, "\tconst uint64_t mux_%zu = (%s >> %u) & 0x%"PRIx64"u; /* %s */\n", i, motorola ? "m" : "i", shift, compiled_mask(sig->bit_length), sig->name);
+		else
+			fprintf(c, "\tconst uint64_t mux_%zu = %s & 0x%"PRIx64"u; /* %s */\n", i, motorola ? "m" : "i", compiled_mask(sig->bit_length), sig->name);
+	}
+	fprintf(c, "\tp->valid = 0;\n");
+	for (size_t i = 0; i < n; i++) {
+		signal_t *sig = msg->sigs[i];
+		bool gmin = false, gmax = false;
+		char *cond = &selected[i * length];
+		signal_range_checks(sig, &gmin, &gmax);
+		fprintf(c, "\t{\n");
+		fprintf(c, "\t\t%s value;\n", signal_decode_type(sig, copts));
+		if (signal2value(sig, c, "\t\t", sig->endianess == endianess_motorola_e ? "m" : "i", "value", copts) < 0)
+			goto fail;
+		if (!gmin && !gmax && !cond[0]) {
+			fprintf(c, "\t\tp->%s = (%s)value;\n", sig->name, type);
+			fprintf(c, "\t\tp->valid |= PHYSICAL_VALID_%s_%s;\n", name, sig->name);
+			fprintf(c, "\t}\n");
+			continue;
+		}
+		fprintf(c, "\t\tconst int ok = ");
+		if (gmin)
+			fprintf(c, "(value >= %g)%s", sig->minimum, gmax || cond[0] ? " && " : "");
+		if (gmax)
+			fprintf(c, "(value <= %g)%s", sig->maximum, cond[0] ? " && " : "");
+		fprintf(c, "%s;\n", cond);
+		fprintf(c, "\t\tp->%s = ok ? (%s)value : 0;\n", sig->name, type);
+		fprintf(c, "\t\tp->valid |= ok ? PHYSICAL_VALID_%s_%s : 0;\n", name, sig->name);
+		fprintf(c, "\t}\n");
+	}
+	free(raw);
+	free(selected);
+	return fprintf(c, "\treturn %u;\n}\n\n", msg->dlc) < 0 ? -1 : 0;
+fail:
+	free(raw);
+	free(selected);
+	return -1;
+}
+
+static int msg2c(can_msg_t *msg, FILE *c, bool merged, dbc2c_options_t *copts, char *god)
+{
+	assert(msg);
+	assert(c);
+	assert(copts);
+	assert(god);
+	char name[MAX_NAME_LENGTH] = {0};
+	make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+	bool motorola_used = false;
+	bool intel_used = false;
+
+	for (size_t i = 0; i < msg->signal_count; i++)
+		if (msg->sigs[i]->endianess == endianess_motorola_e)
+			motorola_used = true;
+		else
+			intel_used = true;
+
+	/* the layout of each message (see layout.h) has already been checked,
+	 * other sanity checks we could do include;
+	 * - odd min/max values given scaling
+	 * - duplicate signals and messages */
+
+	if (compiled_is_fd(msg)) {
+		if (copts->generate_pack && msg_pack_fd(msg, c, name, god, copts) < 0)
+			return -1;
+		if (copts->generate_unpack && msg_unpack_fd(msg, c, name, god, copts) < 0)
+			return -1;
+	} else {
+		if (copts->generate_pack && msg_pack(msg, c, name, motorola_used, intel_used, god, copts) < 0)
+			return -1;
+		if (copts->generate_unpack && msg_unpack(msg, c, name, motorola_used, intel_used, god, copts) < 0)
+			return -1;
+	}
 
 	for (size_t i = 0; i < msg->signal_count; i++) {
 		if (copts->generate_unpack)
-			if (signal2scaling(name, msg->id, msg->sigs[i], c, true, false, god, copts) < 0)
+			if (signal2scaling(name, msg->id, msg->sigs[i], c, true, false, merged, god, copts) < 0)
 				return -1;
 		if (copts->generate_pack)
-			if (signal2scaling(name, msg->id, msg->sigs[i], c, false, false, god, copts) < 0)
+			if (signal2scaling(name, msg->id, msg->sigs[i], c, false, false, merged, god, copts) < 0)
+				return -1;
+		if (signal_has_fixed(msg->sigs[i], copts)) {
+			if (copts->generate_unpack && signal2fixed(name, msg->id, msg->sigs[i], c, true, false, merged, god, copts) < 0)
+				return -1;
+			if (copts->generate_pack && signal2fixed(name, msg->id, msg->sigs[i], c, false, false, merged, god, copts) < 0)
+				return -1;
+		}
+		if (signal_has_extract(msg, msg->sigs[i], copts))
+			if (signal2extract(name, msg->id, msg->sigs[i], c, false, merged, copts) < 0)
 				return -1;
 	}
 
 	if (copts->generate_print && msg_print(msg, c, name, god, copts) < 0)
 		return -1;
 
+	if (msg_has_columns(msg, copts) && msg2c_columns(msg, c, copts) < 0)
+		return -1;
+
+	if (msg_has_physical(msg, copts) && msg2c_physical(msg, c, copts) < 0)
+		return -1;
+
 	return 0;
 }
 
-static int msg2h(can_msg_t *msg, FILE *h, dbc2c_options_t *copts, const char *god)
+static int msg2h(can_msg_t *msg, FILE *h, bool merged, dbc2c_options_t *copts, const char *god)
 {
 	assert(msg);
 	assert(h);
@@ -788,23 +1523,178 @@ static int msg2h(can_msg_t *msg, FILE *h, dbc2c_options_t *copts, const char *go
 
 	for (size_t i = 0; i < msg->signal_count; i++) {
 		if (copts->generate_unpack)
-			if (signal2scaling(name, msg->id, msg->sigs[i], h, true, true, god, copts) < 0)
+			if (signal2scaling(name, msg->id, msg->sigs[i], h, true, true, merged, god, copts) < 0)
 				return -1;
 		if (copts->generate_pack)
-			if (signal2scaling(name, msg->id, msg->sigs[i], h, false, true, god, copts) < 0)
+			if (signal2scaling(name, msg->id, msg->sigs[i], h, false, true, merged, god, copts) < 0)
+				return -1;
+		if (signal_has_fixed(msg->sigs[i], copts) && (copts->generate_unpack || copts->generate_pack)) {
+			if (signal2fixed_report(msg->name, msg->sigs[i], h, copts) < 0)
+				return -1;
+			if (copts->generate_unpack && signal2fixed(name, msg->id, msg->sigs[i], h, true, true, merged, god, copts) < 0)
+				return -1;
+			if (copts->generate_pack && signal2fixed(name, msg->id, msg->sigs[i], h, false, true, merged, god, copts) < 0)
+				return -1;
+		}
+		if (signal_has_extract(msg, msg->sigs[i], copts))
+			if (signal2extract(name, msg->id, msg->sigs[i], h, true, merged, copts) < 0)
 				return -1;
 	}
+	if (msg_has_columns(msg, copts) && msg2h_columns(msg, h, copts) < 0)
+		return -1;
+	if (msg_has_physical(msg, copts) && msg2h_physical(msg, h, copts) < 0)
+		return -1;
 	fputs("\n\n", h);
 	return 0;
 }
 
+/* The byte order of the target is worked out by the generated code, where it
+ * is not known (DBCC_ENDIAN is 0) or there is no byte swap builtin portable
+ * code is used instead, which is correct but slower. */
 static const char *cfunctions =
+"#ifndef DBCC_ENDIAN /* 1 = little endian, 2 = big endian, 0 = unknown */\n"
+"#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)\n"
+"#define DBCC_ENDIAN (1)\n"
+"#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)\n"
+"#define DBCC_ENDIAN (2)\n"
+"#else\n"
+"#define DBCC_ENDIAN (0)\n"
+"#endif\n"
+"#endif\n\n"
+"#ifndef DBCC_BSWAP64\n"
+"#if defined(__has_builtin)\n"
+"#if __has_builtin(__builtin_bswap64)\n"
+"#define DBCC_BSWAP64(X) __builtin_bswap64(X)\n"
+"#endif\n"
+"#elif defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 3)))\n"
+"#define DBCC_BSWAP64(X) __builtin_bswap64(X)\n"
+"#endif\n"
+"#endif\n\n"
 "static inline uint64_t reverse_byte_order(uint64_t x) {\n"
+"#ifdef DBCC_BSWAP64\n"
+"\treturn DBCC_BSWAP64(x);\n"
+"#else\n"
 "\tx = (x & 0x00000000FFFFFFFF) << 32 | (x & 0xFFFFFFFF00000000) >> 32;\n"
 "\tx = (x & 0x0000FFFF0000FFFF) << 16 | (x & 0xFFFF0000FFFF0000) >> 16;\n"
 "\tx = (x & 0x00FF00FF00FF00FF) << 8  | (x & 0xFF00FF00FF00FF00) >> 8;\n"
 "\treturn x;\n"
+"#endif\n"
+"}\n\n";
+
+/* Loads and stores of "n" bytes of a payload, in little (intel) or big
+ * (motorola) endian order, "n" is a constant wherever it can be so that eight
+ * byte loads become one memcpy and possibly a byte swap. Signals are or-ed
+ * into a payload a byte at a time, as reading back a word that overlaps the
+ * bytes just written stalls on most processors. */
+static const char *cfunctions_bytes =
+"static inline uint64_t dbcc_load_le(const uint8_t *d, unsigned n) {\n"
+"\tuint64_t x = 0;\n"
+"#if DBCC_ENDIAN != 0\n"
+"\tif (n == 8) {\n"
+"\t\tmemcpy(&x, d, 8);\n"
+"\t\treturn DBCC_ENDIAN == 1 ? x : reverse_byte_order(x);\n"
+"\t}\n"
+"#endif\n"
+"\twhile (n--)\n"
+"\t\tx = (x << 8) | d[n];\n"
+"\treturn x;\n"
+"}\n\n"
+"static inline uint64_t dbcc_load_be(const uint8_t *d, unsigned n) {\n"
+"\tuint64_t x = 0;\n"
+"#if DBCC_ENDIAN != 0\n"
+"\tif (n == 8) {\n"
+"\t\tmemcpy(&x, d, 8);\n"
+"\t\treturn DBCC_ENDIAN == 2 ? x : reverse_byte_order(x);\n"
+"\t}\n"
+"#endif\n"
+"\tfor (unsigned i = 0; i < n; i++)\n"
+"\t\tx = (x << 8) | d[i];\n"
+"\treturn x;\n"
+"}\n\n"
+"static inline void dbcc_store_le(uint8_t *d, unsigned n, uint64_t x) {\n"
+"#if DBCC_ENDIAN != 0\n"
+"\tif (n == 8) {\n"
+"\t\tx = DBCC_ENDIAN == 1 ? x : reverse_byte_order(x);\n"
+"\t\tmemcpy(d, &x, 8);\n"
+"\t\treturn;\n"
+"\t}\n"
+"#endif\n"
+"\tfor (unsigned i = 0; i < n; i++, x >>= 8)\n"
+"\t\td[i] = (uint8_t)x;\n"
+"}\n\n"
+"static inline void dbcc_or_le(uint8_t *d, unsigned n, uint64_t x) {\n"
+"\tfor (unsigned i = 0; i < n; i++, x >>= 8)\n"
+"\t\td[i] |= (uint8_t)x;\n"
+"}\n\n"
+"static inline void dbcc_or_be(uint8_t *d, unsigned n, uint64_t x) {\n"
+"\twhile (n--) {\n"
+"\t\td[n] |= (uint8_t)x;\n"
+"\t\tx >>= 8;\n"
+"\t}\n"
 "}\n\n";
+
+static const char *hframe =
+"#ifndef DBCC_FRAME\n"
+"#define DBCC_FRAME\n"
+"typedef struct { /* A classic CAN frame, as recorded in a log */\n"
+"\tuint64_t data;    /* payload, the first byte is the lowest byte */\n"
+"\tunsigned long id; /* identifier */\n"
+"\tdbcc_time_stamp_t time_stamp;\n"
+"\tuint8_t dlc;\n"
+"\tuint8_t bus;      /* only used by merged databases, see the CAN_BUS_ enumeration */\n"
+"} dbcc_frame_t;\n"
+"#endif\n\n";
+
+static const char *hfunctions_fd =
+"#ifndef DBCC_FD_LENGTH\n"
+"#define DBCC_FD_LENGTH\n"
+"/* A CAN-FD DLC is a four bit code for a payload of up to 64 bytes */\n"
+"static inline uint8_t dbcc_dlc_to_length(uint8_t dlc) {\n"
+"\tstatic const uint8_t lengths[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64, };\n"
+"\treturn lengths[dlc & 15];\n"
+"}\n\n"
+"/* Returns the smallest DLC whose payload has room for \"length\" bytes */\n"
+"static inline uint8_t dbcc_length_to_dlc(uint8_t length) {\n"
+"\tuint8_t dlc = 0;\n"
+"\twhile (dlc < 15 && dbcc_dlc_to_length(dlc) < length)\n"
+"\t\tdlc++;\n"
+"\treturn dlc;\n"
+"}\n"
+"#endif\n\n";
+/* The functions that decode a signal from many payloads are compiled for
+ * more than one instruction set where the compiler can pick one when the
+ * program is loaded, which is where the processor is checked, a plain loop is
+ * used otherwise. GCC does not vectorize loops at -O2 before version 12, and
+ * only those with a known number of iterations after it, so it is asked to. */
+static const char *cfunctions_extract =
+"#ifndef DBCC_VECTORIZE\n"
+"#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 6) && defined(__x86_64__) && defined(__gnu_linux__)\n"
+"#define DBCC_VECTORIZE __attribute__((target_clones(\"avx2\", \"sse4.2\", \"default\"), optimize(\"tree-vectorize\")))\n"
+"#elif defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 5)\n"
+"#define DBCC_VECTORIZE __attribute__((optimize(\"tree-vectorize\")))\n"
+"#else\n"
+"#define DBCC_VECTORIZE\n"
+"#endif\n"
+"#endif\n\n";
+
+/* Division of "n" by a positive "d" rounding halves away from zero, for
+ * the fixed point functions, "d" is always a constant */
+static const char *cfunctions_fixed =
+"static inline int32_t dbcc_div32(const int32_t n, const int32_t d) {\n"
+"\treturn n >= 0 ? (n + (d / 2)) / d : -(((d / 2) - n) / d);\n"
+"}\n\n"
+"static inline int64_t dbcc_div64(const int64_t n, const int64_t d) {\n"
+"\treturn n >= 0 ? (n + (d / 2)) / d : -(((d / 2) - n) / d);\n"
+"}\n\n";
+
+/* The columns are allocated with realloc unless these are defined */
+static const char *cfunctions_columns =
+"#ifndef DBCC_REALLOC\n"
+"#include <stdlib.h>\n"
+"#define DBCC_REALLOC(P, N) realloc((P), (N))\n"
+"#define DBCC_FREE(P) free(P)\n"
+"#endif\n\n";
+
 static const char *cfunctions_print_only =
 "static inline int print_helper(int r, int print_return_value) {\n"
 "\treturn ((r >= 0) && (print_return_value >= 0)) ? r + print_return_value : -1;\n"
@@ -816,6 +1706,7 @@ static int message_compare_function(const void *a, const void *b)
 	assert(b);
 	can_msg_t *ap = *((can_msg_t**)a);
 	can_msg_t *bp = *((can_msg_t**)b);
+	if (ap->bus != bp->bus) return ap->bus < bp->bus ? -1 : 1;
 	if (ap->id <  bp->id) return -1;
 	if (ap->id == bp->id) return  0;
 	if (ap->id >  bp->id) return  1;
@@ -834,6 +1725,383 @@ static int signal_compare_function(const void *a, const void *b)
 	return 0;
 }
 
+/* In a merged database (see dbc_merge) the dispatch functions take the bus
+ * as well as the identifier, the messages are sorted by bus and the switch
+ * on the identifier is nested within one on the bus. */
+static const char *switch_bus_parameter(const dbc_t *dbc)
+{
+	assert(dbc);
+	return dbc->bus_count ? "const unsigned bus, " : "";
+}
+
+/* The bus must be one of those merged whichever way messages are dispatched */
+static void assert_bus(FILE *c, const dbc_t *dbc, const dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(copts);
+	if (dbc->bus_count && copts->generate_asserts)
+		fprintf(c, "\tassert(bus < %zu);\n", dbc->bus_count);
+}
+
+static void switch_begin(FILE *c, const dbc_t *dbc, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(copts);
+	if (!dbc->bus_count) {
+		fprintf(c, "\tswitch (id) {\n");
+		return;
+	}
+	assert_bus(c, dbc, copts);
+	fprintf(c, "\tswitch (bus) {\n");
+}
+
+/* Returns the indentation for the case of a message, "open" is the bus
+ * whose case is open, which starts off as SWITCH_CLOSED, not every message
+ * need have a case. */
+#define SWITCH_CLOSED (UINT_MAX)
+
+static const char *switch_case(FILE *c, const dbc_t *dbc, const can_msg_t *msg, unsigned *open)
+{
+	assert(c);
+	assert(dbc);
+	assert(msg);
+	assert(open);
+	if (!dbc->bus_count)
+		return "\t";
+	if (*open != msg->bus) {
+		if (*open != SWITCH_CLOSED)
+			fprintf(c, "\t\tdefault: break;\n\t\t}\n\t\tbreak;\n");
+		fprintf(c, "\tcase %u: /* %s */\n\t\tswitch (id) {\n", msg->bus, dbc->buses[msg->bus]);
+		*open = msg->bus;
+	}
+	return "\t\t";
+}
+
+static void switch_end(FILE *c, const dbc_t *dbc, unsigned open)
+{
+	assert(c);
+	assert(dbc);
+	if (dbc->bus_count && open != SWITCH_CLOSED)
+		fprintf(c, "\t\tdefault: break;\n\t\t}\n\t\tbreak;\n");
+	fprintf(c, "\tdefault: break; \n\t}\n");
+}
+
+static bool dbc_has_fd(const dbc_t *dbc)
+{
+	assert(dbc);
+	for (size_t i = 0; i < dbc->message_count; i++)
+		if (compiled_is_fd(dbc->messages[i]))
+			return true;
+	return false;
+}
+
+/* Instead of a switch on the identifier, which a compiler may turn into a
+ * long chain of comparisons when there are many sparse identifiers, each
+ * message can be found by its index in the database, a switch on which is
+ * dense. The index is looked up from the bus and identifier in a two level table if
+ * the identifiers are all standard ones, or with a hash that has no
+ * collisions for the identifiers in the database (hash and displace, each
+ * bucket of identifiers gets a seed that puts them in free slots). */
+
+#define DISPATCH_PAGE  (32u)   /* identifiers per page of a two level table */
+#define DISPATCH_PAGES (2048u / DISPATCH_PAGE)
+
+typedef struct {
+	size_t slots, buckets; /**< both are powers of two */
+	uint32_t *seeds;       /**< one per bucket */
+	size_t *message;       /**< one per slot, index of message plus one, zero if empty */
+} dispatch_hash_t;
+
+/* This must be the same as "dbcc_hash" in the generated code */
+static uint32_t dispatch_hash(uint64_t key, uint32_t seed)
+{
+	key = (key ^ seed) * 0x9E3779B97F4A7C15uLL;
+	return (uint32_t)(key >> 32);
+}
+
+static uint64_t dispatch_key(const can_msg_t *msg)
+{
+	assert(msg);
+	return ((uint64_t)msg->bus << 32) ^ (uint64_t)msg->id;
+}
+
+static size_t power_of_two(size_t n)
+{
+	size_t r = 1;
+	while (r < n)
+		r <<= 1;
+	return r;
+}
+
+typedef struct {
+	size_t bucket, first, count; /**< "first" is the index of its first member */
+} dispatch_bucket_t;
+
+static int dispatch_bucket_compare(const void *a, const void *b)
+{
+	assert(a);
+	assert(b);
+	const dispatch_bucket_t *x = a, *y = b;
+	if (x->count != y->count)
+		return x->count > y->count ? -1 : 1;
+	return x->bucket < y->bucket ? -1 : x->bucket > y->bucket;
+}
+
+/* Places the members of each bucket, largest first, returns false if some
+ * bucket has no seed that puts its members in free slots */
+static bool dispatch_hash_place(dispatch_hash_t *h, const dbc_t *dbc, const dispatch_bucket_t *b, const size_t *members)
+{
+	assert(h);
+	assert(dbc);
+	assert(b);
+	assert(members);
+	const size_t mask = h->slots - 1;
+	for (size_t i = 0; i < h->buckets && b[i].count; i++) {
+		bool placed = false;
+		for (uint32_t seed = 1; seed < (1uL << 16) && !placed; seed++) {
+			size_t j = 0;
+			for (; j < b[i].count; j++) {
+				const size_t m = members[b[i].first + j];
+				const size_t s = dispatch_hash(dispatch_key(dbc->messages[m]), seed) & mask;
+				if (h->message[s])
+					break;
+				h->message[s] = m + 1;
+			}
+			placed = j == b[i].count;
+			h->seeds[b[i].bucket] = seed;
+			while (!placed && j--) /* undo a failed attempt */
+				h->message[dispatch_hash(dispatch_key(dbc->messages[members[b[i].first + j]]), seed) & mask] = 0;
+		}
+		if (!placed)
+			return false;
+	}
+	return true;
+}
+
+static void dispatch_hash_build(dispatch_hash_t *h, const dbc_t *dbc)
+{
+	assert(h);
+	assert(dbc);
+	const size_t n = dbc->message_count;
+	h->buckets = power_of_two(n / 4 ? n / 4 : 1);
+	dispatch_bucket_t *b = allocate(h->buckets * sizeof(*b));
+	size_t *members = allocate((n + 1) * sizeof(*members));
+	size_t *in = allocate((n + 1) * sizeof(*in));
+	for (size_t i = 0; i < h->buckets; i++)
+		b[i].bucket = i;
+	for (size_t i = 0; i < n; i++) {
+		in[i] = dispatch_hash(dispatch_key(dbc->messages[i]), 0) & (h->buckets - 1);
+		b[in[i]].count++;
+	}
+	for (size_t i = 0, first = 0; i < h->buckets; first += b[i].count, i++)
+		b[i].first = first;
+	size_t *next = allocate(h->buckets * sizeof(*next));
+	for (size_t i = 0; i < n; i++)
+		members[b[in[i]].first + next[in[i]]++] = i;
+	free(next);
+	qsort(b, h->buckets, sizeof(*b), dispatch_bucket_compare);
+
+	for (h->slots = power_of_two(n * 2);; h->slots <<= 1) {
+		free(h->seeds);
+		free(h->message);
+		h->seeds   = allocate(h->buckets * sizeof(*h->seeds));
+		h->message = allocate(h->slots * sizeof(*h->message));
+		if (dispatch_hash_place(h, dbc, b, members))
+			break;
+		if (h->slots > (n * 64))
+			error("could not build a hash of the message identifiers");
+	}
+	debug("dispatch hash: %zu messages, %zu slots, %zu buckets", n, h->slots, h->buckets);
+	free(b);
+	free(members);
+	free(in);
+}
+
+static const char *index_type(size_t n)
+{
+	return n < UINT8_MAX ? "uint8_t" : n < UINT16_MAX ? "uint16_t" : "uint32_t";
+}
+
+/* The table, and possibly the hash, can only be used for some databases,
+ * the switch is used when they cannot be. */
+static dbc2c_dispatch_e dispatch_method(const dbc_t *dbc, const dbc2c_options_t *copts)
+{
+	assert(dbc);
+	assert(copts);
+	if (copts->dispatch == DBC2C_DISPATCH_SWITCH || dbc->message_count == 0)
+		return DBC2C_DISPATCH_SWITCH;
+	for (size_t i = 1; i < dbc->message_count; i++) {
+		if (dispatch_key(dbc->messages[i - 1]) == dispatch_key(dbc->messages[i])) {
+			warning("duplicate message identifier 0x%lx, using a switch to dispatch messages", dbc->messages[i]->id);
+			return DBC2C_DISPATCH_SWITCH;
+		}
+	}
+	if (copts->dispatch == DBC2C_DISPATCH_TABLE) {
+		for (size_t i = 0; i < dbc->message_count; i++) {
+			if (dbc->messages[i]->id >= (DISPATCH_PAGES * DISPATCH_PAGE)) {
+				note("identifier 0x%lx is not a standard one, using a hash to dispatch messages", dbc->messages[i]->id);
+				return DBC2C_DISPATCH_HASH;
+			}
+		}
+	}
+	return copts->dispatch;
+}
+
+static int dispatch_index_table(FILE *c, dbc_t *dbc)
+{
+	assert(c);
+	assert(dbc);
+	const size_t buses = dbc->bus_count ? dbc->bus_count : 1;
+	size_t *pages = allocate(buses * DISPATCH_PAGES * sizeof(*pages));
+	size_t used = 1; /* page zero is empty */
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		const can_msg_t *msg = dbc->messages[i];
+		const size_t p = (msg->bus * DISPATCH_PAGES) + (msg->id / DISPATCH_PAGE);
+		if (!pages[p])
+			pages[p] = used++;
+	}
+	fprintf(c, "static const %s dispatch_pages[%zu] = {", index_type(used), buses * DISPATCH_PAGES);
+	for (size_t i = 0; i < buses * DISPATCH_PAGES; i++)
+		fprintf(c, "%s%zu,", i % 16 ? " " : "\n\t", pages[i]);
+	fprintf(c, "\n};\n\n");
+
+	/* messages are sorted by bus and identifier, so are the pages */
+	fprintf(c, "static const %s dispatch_slots[%zu][%u] = { /* index of message plus one */\n\t{ 0, },\n", index_type(dbc->message_count + 1), used, DISPATCH_PAGE);
+	for (size_t i = 0; i < dbc->message_count;) {
+		const can_msg_t *msg = dbc->messages[i];
+		const size_t p = (msg->bus * DISPATCH_PAGES) + (msg->id / DISPATCH_PAGE);
+		size_t slots[DISPATCH_PAGE] = { 0, };
+		for (; i < dbc->message_count; i++) {
+			const can_msg_t *m = dbc->messages[i];
+			if ((m->bus * DISPATCH_PAGES) + (m->id / DISPATCH_PAGE) != p)
+				break;
+			slots[m->id % DISPATCH_PAGE] = i + 1;
+		}
+		fprintf(c, "\t{");
+		for (size_t j = 0; j < DISPATCH_PAGE; j++)
+			fprintf(c, " %zu,", slots[j]);
+		fprintf(c, " },\n");
+	}
+	fprintf(c, "};\n\n");
+	free(pages);
+
+	fprintf(c, "static inline int dispatch_index(%sconst unsigned long id) {\n", switch_bus_parameter(dbc));
+	if (dbc->bus_count)
+		fprintf(c, "\tif (id >= %u || bus >= %zu)\n\t\treturn -1;\n", DISPATCH_PAGES * DISPATCH_PAGE, dbc->bus_count);
+	else
+		fprintf(c, "\tif (id >= %u)\n\t\treturn -1;\n", DISPATCH_PAGES * DISPATCH_PAGE);
+	if (dbc->bus_count)
+		fprintf(c, "\treturn (int)dispatch_slots[dispatch_pages[(bus * %u) + (id / %u)]][id %% %u] - 1;\n}\n\n", DISPATCH_PAGES, DISPATCH_PAGE, DISPATCH_PAGE);
+	else
+		fprintf(c, "\treturn (int)dispatch_slots[dispatch_pages[id / %u]][id %% %u] - 1;\n}\n\n", DISPATCH_PAGE, DISPATCH_PAGE);
+	return 0;
+}
+
+static int dispatch_index_hash(FILE *c, dbc_t *dbc)
+{
+	assert(c);
+	assert(dbc);
+	dispatch_hash_t h = { .seeds = NULL, };
+	dispatch_hash_build(&h, dbc);
+
+	fprintf(c, "static inline uint32_t dbcc_hash(uint64_t key, uint32_t seed) {\n");
+	fprintf(c, "\tkey = (key ^ seed) * 0x9E3779B97F4A7C15ull;\n");
+	fprintf(c, "\treturn (uint32_t)(key >> 32);\n}\n\n");
+
+	fprintf(c, "static const uint16_t dispatch_seeds[%zu] = {", h.buckets);
+	for (size_t i = 0; i < h.buckets; i++)
+		fprintf(c, "%s%"PRIu32",", i % 16 ? " " : "\n\t", h.seeds[i]);
+	fprintf(c, "\n};\n\n");
+
+	fprintf(c, "static const struct {\n\tuint32_t id;\n");
+	if (dbc->bus_count)
+		fprintf(c, "\t%s bus;\n", index_type(dbc->bus_count));
+	fprintf(c, "\t%s message; /* index of message plus one, zero if empty */\n", index_type(dbc->message_count + 1));
+	fprintf(c, "} dispatch_slots[%zu] = {\n", h.slots);
+	for (size_t i = 0; i < h.slots; i++) {
+		const can_msg_t *msg = h.message[i] ? dbc->messages[h.message[i] - 1] : NULL;
+		if (dbc->bus_count)
+			fprintf(c, "\t{ 0x%lx, %u, %zu, },\n", msg ? msg->id : 0, msg ? msg->bus : 0, h.message[i]);
+		else
+			fprintf(c, "\t{ 0x%lx, %zu, },\n", msg ? msg->id : 0, h.message[i]);
+	}
+	fprintf(c, "};\n\n");
+
+	fprintf(c, "static inline int dispatch_index(%sconst unsigned long id) {\n", switch_bus_parameter(dbc));
+	fprintf(c, "\tconst uint64_t key = %s(uint64_t)id;\n", dbc->bus_count ? "((uint64_t)bus << 32) ^ " : "");
+	fprintf(c, "\tconst size_t slot = dbcc_hash(key, dispatch_seeds[dbcc_hash(key, 0) & %zuu]) & %zuu;\n", h.buckets - 1, h.slots - 1);
+	fprintf(c, "\tif (dispatch_slots[slot].id != id%s)\n\t\treturn -1;\n", dbc->bus_count ? " || dispatch_slots[slot].bus != bus" : "");
+	fprintf(c, "\treturn (int)dispatch_slots[slot].message - 1;\n}\n\n");
+	free(h.seeds);
+	free(h.message);
+	return 0;
+}
+
+/* The index is the position of a message in the database, the functions
+ * for each message are called from a switch on it, which a compiler turns
+ * into a jump table as the cases are dense. */
+static int dispatch_tables(FILE *c, dbc_t *dbc, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(copts);
+	if (copts->dispatch == DBC2C_DISPATCH_SWITCH)
+		return 0;
+	const int r = copts->dispatch == DBC2C_DISPATCH_TABLE ? dispatch_index_table(c, dbc) : dispatch_index_hash(c, dbc);
+	if (r < 0)
+		return -1;
+	if (copts->generate_pack) {
+		fprintf(c, "static const uint8_t dispatch_dlc[%zu] = {", dbc->message_count);
+		for (size_t i = 0; i < dbc->message_count; i++)
+			fprintf(c, "%s%u,", i % 16 ? " " : "\n\t", dbc->messages[i]->dlc);
+		fprintf(c, "\n};\n\n");
+	}
+	return 0;
+}
+
+static void dispatch_begin(FILE *c, dbc_t *dbc, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(copts);
+	if (copts->dispatch == DBC2C_DISPATCH_SWITCH) {
+		switch_begin(c, dbc, copts);
+		return;
+	}
+	assert_bus(c, dbc, copts);
+	fprintf(c, "\tswitch (dispatch_index(%sid)) {\n", dbc->bus_count ? "bus, " : "");
+}
+
+/* Returns the case label for message "i", "label" must be long enough */
+static const char *dispatch_case(FILE *c, const dbc_t *dbc, size_t i, unsigned *open, const dbc2c_options_t *copts, char label[64])
+{
+	assert(c);
+	assert(dbc);
+	assert(open);
+	assert(copts);
+	assert(label);
+	assert(i < dbc->message_count);
+	const can_msg_t *msg = dbc->messages[i];
+	if (copts->dispatch == DBC2C_DISPATCH_SWITCH)
+		snprintf(label, 64, "%scase 0x%03lx:", switch_case(c, dbc, msg, open), msg->id);
+	else
+		snprintf(label, 64, "\tcase %zu:", i);
+	return label;
+}
+
+static void dispatch_end(FILE *c, const dbc_t *dbc, unsigned open, const dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(copts);
+	if (copts->dispatch == DBC2C_DISPATCH_SWITCH)
+		switch_end(c, dbc, open);
+	else
+		fprintf(c, "\tdefault: break; \n\t}\n");
+}
+
 static int switch_function(FILE *c, dbc_t *dbc, char *function, bool unpack,
 		bool prototype, const char *datatype, bool dlc, const char *god, dbc2c_options_t *copts)
 {
@@ -842,8 +2110,8 @@ static int switch_function(FILE *c, dbc_t *dbc, char *function, bool unpack,
 	assert(function);
 	assert(god);
 	assert(copts);
-	fprintf(c, "int %s_message(can_obj_%s_t *o, const unsigned long id, %s %sdata%s)",
-			function, god, datatype, unpack ? "" : "*",
+	fprintf(c, "int %s_message(can_obj_%s_t *o, %sconst unsigned long id, %s %sdata%s)",
+			function, god, switch_bus_parameter(dbc), datatype, unpack ? "" : "*",
 			dlc ? ", uint8_t dlc, dbcc_time_stamp_t time_stamp" : "");
 	if (prototype)
 		return fprintf(c, ";\n");
@@ -854,19 +2122,26 @@ static int switch_function(FILE *c, dbc_t *dbc, char *function, bool unpack,
 		if (dlc)
 			fprintf(c, "\tassert(dlc <= 8);         /* Maximum of 8 bytes in a CAN packet */\n");
 	}
-
-	fprintf(c, "\tswitch (id) {\n");
+	bool classic = false;
+	for (size_t i = 0; i < dbc->message_count; i++)
+		classic = classic || !compiled_is_fd(dbc->messages[i]);
+	if (!classic) /* every message is CAN-FD, none are dispatched */
+		fprintf(c, "\tUNUSED(o);\n\tUNUSED(data);\n%s", dlc ? "\tUNUSED(dlc);\n\tUNUSED(time_stamp);\n" : "");
+	unsigned open = SWITCH_CLOSED;
+	dispatch_begin(c, dbc, copts);
 	for (size_t i = 0; i < dbc->message_count; i++) {
 		can_msg_t *msg = dbc->messages[i];
-		char name[MAX_NAME_LENGTH] = {0};
+		if (compiled_is_fd(msg)) /* see switch_function_bytes */
+			continue;
+		char name[MAX_NAME_LENGTH] = {0}, label[64] = {0};
 		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
-		fprintf(c, "\tcase 0x%03lx: return %s_%s(o, data%s);\n",
-				msg->id,
+		fprintf(c, "%s return %s_%s(o, data%s);\n",
+				dispatch_case(c, dbc, i, &open, copts, label),
 				function,
 				name,
 				dlc ? ", dlc, time_stamp" : "");
 	}
-	fprintf(c, "\tdefault: break; \n\t}\n");
+	dispatch_end(c, dbc, open, copts);
 	return fprintf(c, "\treturn -1; \n}\n\n") < 0 ? -1 : 0;
 }
 
@@ -876,7 +2151,7 @@ static int switch_function_print(FILE *c, dbc_t *dbc, bool prototype, const char
 	assert(dbc);
 	assert(god);
 	assert(copts);
-	fprintf(c, "int print_message(const can_obj_%s_t *o, const unsigned long id, FILE *output)", god);
+	fprintf(c, "int print_message(const can_obj_%s_t *o, %sconst unsigned long id, FILE *output)", god, switch_bus_parameter(dbc));
 	if (prototype)
 		return fprintf(c, ";\n");
 	fprintf(c, " {\n");
@@ -885,15 +2160,15 @@ static int switch_function_print(FILE *c, dbc_t *dbc, bool prototype, const char
 		fprintf(c, "\tassert(id < (1ul << 29)); /* 29-bit CAN ID is largest possible */\n");
 		fprintf(c, "\tassert(output);\n");
 	}
-
-	fprintf(c, "\tswitch (id) {\n");
+	unsigned open = SWITCH_CLOSED;
+	dispatch_begin(c, dbc, copts);
 	for (size_t i = 0; i < dbc->message_count; i++) {
 		can_msg_t *msg = dbc->messages[i];
-		char name[MAX_NAME_LENGTH] = {0};
+		char name[MAX_NAME_LENGTH] = {0}, label[64] = {0};
 		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
-		fprintf(c, "\tcase 0x%03lx: return print_%s(o, output);\n", msg->id, name);
+		fprintf(c, "%s return print_%s(o, output);\n", dispatch_case(c, dbc, i, &open, copts, label), name);
 	}
-	fprintf(c, "\tdefault: break; \n\t}\n");
+	dispatch_end(c, dbc, open, copts);
 	return fprintf(c, "\treturn -1; \n}\n\n");
 }
 
@@ -902,22 +2177,219 @@ static int switch_message_dlc(FILE *c, dbc_t *dbc, bool prototype, dbc2c_options
 	assert(c);
 	assert(dbc);
 	assert(copts);
-	fprintf(c, "int message_dlc(const unsigned long id)");
+	fprintf(c, "int message_dlc(%sconst unsigned long id)", switch_bus_parameter(dbc));
 	if (prototype)
 		return fprintf(c, ";\n");
 	fprintf(c, " {\n");
 	if (copts->generate_asserts)
 		fprintf(c, "\tassert(id < (1ul << 29)); /* 29-bit CAN ID is largest possible */\n");
+	if (copts->dispatch != DBC2C_DISPATCH_SWITCH) {
+		assert_bus(c, dbc, copts);
+		fprintf(c, "\tconst int i = dispatch_index(%sid);\n", dbc->bus_count ? "bus, " : "");
+		return fprintf(c, "\treturn i < 0 ? -1 : dispatch_dlc[i];\n}\n\n");
+	}
 
-	fprintf(c, "\tswitch (id) {\n");
+	unsigned open = SWITCH_CLOSED;
+	switch_begin(c, dbc, copts);
 	for (size_t i = 0; i < dbc->message_count; i++) {
 		can_msg_t *msg = dbc->messages[i];
+		const char *indent = switch_case(c, dbc, msg, &open);
+		fprintf(c, "%scase 0x%03lx: return %d;\n", indent, msg->id, msg->dlc);
+	}
+	switch_end(c, dbc, open);
+	return fprintf(c, "\treturn -1; \n}\n\n");
+}
+
+/* CAN-FD messages are not in "unpack_message" and "pack_message" as they do
+ * not fit in a 64-bit word, they and the classic messages are dispatched by
+ * functions that take a byte buffer instead, the first byte of which is the
+ * lowest byte of the 64-bit word used for classic messages. Callers need not
+ * assemble that word themselves, which is often done a byte at a time. */
+static int switch_function_bytes(FILE *c, dbc_t *dbc, bool unpack, bool prototype, const char *god, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(god);
+	assert(copts);
+	bool classic = false;
+	for (size_t i = 0; i < dbc->message_count; i++)
+		classic = classic || !compiled_is_fd(dbc->messages[i]);
+	if (unpack)
+		fprintf(c, "int unpack_message_bytes(can_obj_%s_t *o, %sconst unsigned long id, const uint8_t *data, uint8_t length, dbcc_time_stamp_t time_stamp)", god, switch_bus_parameter(dbc));
+	else
+		fprintf(c, "int pack_message_bytes(can_obj_%s_t *o, %sconst unsigned long id, uint8_t *data)", god, switch_bus_parameter(dbc));
+	if (prototype)
+		return fprintf(c, ";\n");
+	fprintf(c, " {\n");
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(o);\n");
+		fprintf(c, "\tassert(data);\n");
+		fprintf(c, "\tassert(id < (1ul << 29)); /* 29-bit CAN ID is largest possible */\n");
+		if (unpack)
+			fprintf(c, "\tassert(length <= %u); /* Maximum of %u bytes in a CAN-FD packet */\n", CAN_FD_MAX_DLC, CAN_FD_MAX_DLC);
+	}
+	if (classic && unpack)
+		fprintf(c, "\tconst uint8_t classic = length < %u ? length : %u;\n", CAN_MAX_DLC, CAN_MAX_DLC);
+	if (classic && !unpack)
+		fprintf(c, "\tuint64_t x = 0;\n\tint r = -1;\n");
+
+	unsigned open = SWITCH_CLOSED;
+	dispatch_begin(c, dbc, copts);
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *msg = dbc->messages[i];
+		char name[MAX_NAME_LENGTH] = {0}, label[64] = {0};
+		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+		dispatch_case(c, dbc, i, &open, copts, label);
+		if (compiled_is_fd(msg))
+			fprintf(c, unpack ? "%s return unpack_%s(o, data, length, time_stamp);\n" : "%s return pack_%s(o, data);\n", label, name);
+		else if (unpack)
+			fprintf(c, "%s return unpack_%s(o, dbcc_load_le(data, classic), classic, time_stamp);\n", label, name);
+		else
+			fprintf(c, "%s r = pack_%s(o, &x); break;\n", label, name);
+	}
+	dispatch_end(c, dbc, open, copts);
+	if (classic && !unpack)
+		return fprintf(c, "\tif (r > 0)\n\t\tdbcc_store_le(data, r, x);\n\treturn r;\n}\n\n") < 0 ? -1 : 0;
+	return fprintf(c, "\treturn -1; \n}\n\n") < 0 ? -1 : 0;
+}
+
+/* Decoding a log a frame at a time pays for finding the message of each
+ * frame, consecutive frames with the same identifier are common in logs
+ * (and in logs sorted by identifier) so the message is found once for each
+ * run of them, by "unpack_messages_run", which calls its function for each
+ * frame through a pointer. A loop for each message would be inlined into one
+ * function, which compilers take minutes over for thousands of messages. The
+ * status of each frame is what "unpack_message" would return for it. */
+static int switch_function_batch(FILE *c, dbc_t *dbc, bool prototype, const char *god, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(god);
+	assert(copts);
+	if (prototype)
+		return fprintf(c, "size_t unpack_messages(can_obj_%s_t *o, const dbcc_frame_t *frames, size_t n, int *status);\n", god) < 0 ? -1 : 0;
+
+	fprintf(c, "static size_t unpack_messages_run(can_obj_%s_t *o, %sconst unsigned long id, const dbcc_frame_t *frames, size_t n, int *status) {\n", god, switch_bus_parameter(dbc));
+	fprintf(c, "\tint (*unpack)(can_obj_%s_t *o, uint64_t data, uint8_t dlc, dbcc_time_stamp_t time_stamp) = NULL;\n", god);
+	unsigned open = SWITCH_CLOSED;
+	dispatch_begin(c, dbc, copts);
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *msg = dbc->messages[i];
+		if (compiled_is_fd(msg)) /* see switch_function_bytes */
+			continue;
+		char name[MAX_NAME_LENGTH] = {0}, label[64] = {0};
+		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+		fprintf(c, "%s unpack = unpack_%s; break;\n", dispatch_case(c, dbc, i, &open, copts, label), name);
+	}
+	dispatch_end(c, dbc, open, copts);
+	fprintf(c, "\tsize_t decoded = 0;\n");
+	fprintf(c, "\tfor (size_t i = 0; i < n; i++) {\n");
+	fprintf(c, "\t\tconst int r = unpack ? unpack(o, frames[i].data, frames[i].dlc, frames[i].time_stamp) : -1;\n");
+	fprintf(c, "\t\tdecoded += r >= 0;\n");
+	fprintf(c, "\t\tif (status)\n\t\t\tstatus[i] = r;\n");
+	fprintf(c, "\t}\n\treturn decoded;\n}\n\n");
+
+	fprintf(c, "size_t unpack_messages(can_obj_%s_t *o, const dbcc_frame_t *frames, size_t n, int *status) {\n", god);
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(o);\n");
+		fprintf(c, "\tassert(frames || n == 0);\n");
+	}
+	fprintf(c, "\tsize_t decoded = 0;\n");
+	fprintf(c, "\tfor (size_t i = 0, j = 0; i < n; i = j) {\n");
+	fprintf(c, "\t\tconst unsigned long id = frames[i].id;\n");
+	if (dbc->bus_count) {
+		fprintf(c, "\t\tconst unsigned bus = frames[i].bus;\n");
+		fprintf(c, "\t\tfor (j = i + 1; j < n && frames[j].id == id && frames[j].bus == bus; j++)\n\t\t\t;\n");
+	} else {
+		fprintf(c, "\t\tfor (j = i + 1; j < n && frames[j].id == id; j++)\n\t\t\t;\n");
+	}
+	fprintf(c, "\t\tdecoded += unpack_messages_run(o, %sid, frames + i, j - i, status ? status + i : NULL);\n", dbc->bus_count ? "bus, " : "");
+	return fprintf(c, "\t}\n\treturn decoded;\n}\n\n") < 0 ? -1 : 0;
+}
+
+static bool dbc_has_columns(const dbc_t *dbc, dbc2c_options_t *copts)
+{
+	assert(dbc);
+	assert(copts);
+	for (size_t i = 0; i < dbc->message_count; i++)
+		if (msg_has_columns(dbc->messages[i], copts))
+			return true;
+	return false;
+}
+
+static int msg2h_columns_object(dbc_t *dbc, FILE *h, const char *god, dbc2c_options_t *copts)
+{
+	assert(dbc);
+	assert(h);
+	assert(god);
+	assert(copts);
+	for (size_t i = 0; i < dbc->message_count; i++)
+		if (msg_has_columns(dbc->messages[i], copts) && msg2h_columns_type(dbc->messages[i], h, copts) < 0)
+			return -1;
+	fprintf(h, "typedef struct {\n");
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *msg = dbc->messages[i];
+		if (!msg_has_columns(msg, copts))
+			continue;
 		char name[MAX_NAME_LENGTH] = {0};
 		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
-		fprintf(c, "\tcase 0x%03lx: return %d;\n", msg->id, msg->dlc);
+		fprintf(h, "\t%s_columns_t %s;\n", name, name);
 	}
-	fprintf(c, "\tdefault: break; \n\t}\n");
-	return fprintf(c, "\treturn -1; \n}\n\n");
+	return fprintf(h, "} can_columns_%s_t;\n\n", god) < 0 ? -1 : 0;
+}
+
+/* "unpack_columns" appends a row to the columns of a message, "clear_columns"
+ * empties them without freeing them so that they can be reused */
+static int switch_function_columns(FILE *c, dbc_t *dbc, bool prototype, const char *god, dbc2c_options_t *copts)
+{
+	assert(c);
+	assert(dbc);
+	assert(god);
+	assert(copts);
+	const char *functions[] = { "clear", "free", };
+	fprintf(c, "int unpack_columns(can_columns_%s_t *c, %sconst unsigned long id, uint64_t data, uint8_t dlc, dbcc_time_stamp_t time_stamp)", god, switch_bus_parameter(dbc));
+	if (prototype) {
+		fprintf(c, ";\n");
+		for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+			fprintf(c, "void %s_columns(can_columns_%s_t *c);\n", functions[i], god);
+		return 0;
+	}
+	fprintf(c, " {\n");
+	if (copts->generate_asserts) {
+		fprintf(c, "\tassert(c);\n");
+		fprintf(c, "\tassert(id < (1ul << 29)); /* 29-bit CAN ID is largest possible */\n");
+	}
+	unsigned open = SWITCH_CLOSED;
+	dispatch_begin(c, dbc, copts);
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *msg = dbc->messages[i];
+		if (!msg_has_columns(msg, copts))
+			continue;
+		char name[MAX_NAME_LENGTH] = {0}, label[64] = {0};
+		make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+		fprintf(c, "%s return unpack_columns_%s(&c->%s, data, dlc, time_stamp);\n", dispatch_case(c, dbc, i, &open, copts, label), name, name);
+	}
+	dispatch_end(c, dbc, open, copts);
+	fprintf(c, "\treturn -1; \n}\n\n");
+
+	for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); f++) {
+		fprintf(c, "void %s_columns(can_columns_%s_t *c) {\n", functions[f], god);
+		if (copts->generate_asserts)
+			fprintf(c, "\tassert(c);\n");
+		for (size_t i = 0; i < dbc->message_count; i++) {
+			can_msg_t *msg = dbc->messages[i];
+			if (!msg_has_columns(msg, copts))
+				continue;
+			char name[MAX_NAME_LENGTH] = {0};
+			make_name(name, MAX_NAME_LENGTH, msg->name, msg->id, copts);
+			if (f == 0)
+				fprintf(c, "\tc->%s.count = 0;\n", name);
+			else
+				fprintf(c, "\tfree_columns_%s(&c->%s);\n", name, name);
+		}
+		fprintf(c, "}\n\n");
+	}
+	return 0;
 }
 
 // TODO: Define enums as well/instead of.
@@ -956,6 +2428,26 @@ static void msg2h_define_can_ids(dbc_t *dbc, FILE *h, dbc2c_options_t *copts) {
 	fprintf(h, "\n");
 }
 
+static void msg2h_define_can_buses(dbc_t *dbc, FILE *h) {
+	assert(dbc);
+	assert(h);
+
+	if (dbc->bus_count == 0)
+		return;
+
+	fprintf(h, "enum {\n");
+	for (size_t i = 0; i < dbc->bus_count; i++) {
+		char *name = duplicate(dbc->buses[i]);
+
+		for (size_t i = 0; name[i] != 0; i++)
+			name[i] = toupper(name[i]);
+		fprintf(h, "\tCAN_BUS_%s = %zu,\n", name, i);
+
+		free(name);
+	}
+	fprintf(h, "};\n\n");
+}
+
 static char *escape_string(const char *s, int upper) {
 	const size_t max_char_len = 4;
 	const size_t l = strlen(s) * max_char_len + 1;
@@ -1097,6 +2589,11 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 		qsort(msg->sigs, msg->signal_count, sizeof(msg->sigs[0]), signal_compare_function);
 	}
 
+	const bool fd = dbc_has_fd(dbc);
+	dbc2c_options_t options = *copts;
+	options.dispatch = dispatch_method(dbc, copts);
+	copts = &options;
+
 	/* header file (begin) */
 	fprintf(h, "/* CAN message encoder/decoder: automatically generated - do not edit.\n\n");
 	if (copts->use_time_stamps)
@@ -1114,6 +2611,7 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 		"   an older version of the generator. You can specify this on the command line with\n"
 		"   the -n option. */\n"
 		"#define DBCC_GENERATOR_VERSION (%d)\n\n"
+		"#include <stddef.h>\n"
 		"#include <stdint.h>\n"
 		"%s\n\n"
 		"#ifdef __cplusplus\n"
@@ -1149,6 +2647,9 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 	fprintf(h, "typedef uint32_t dbcc_time_stamp_t; /* Time stamp for message; you decide on units */\n");
 	fprintf(h, "#endif\n\n");
 
+	if (copts->generate_unpack)
+		fputs(hframe, h);
+
 	fprintf(h, "#ifndef DBCC_STATUS_ENUM\n");
 	fprintf(h, "#define DBCC_STATUS_ENUM\n");
 	fprintf(h, "typedef enum {\n");
@@ -1158,6 +2659,7 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 	fprintf(h, "} dbcc_signal_status_e;\n");
 	fprintf(h, "#endif\n\n");
 
+	msg2h_define_can_buses(dbc, h);
 	msg2h_define_can_ids(dbc, h, copts);
 
 	if (msg2h_types(dbc, h, copts) < 0) {
@@ -1171,8 +2673,27 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 		goto fail;
 	}
 
-	if (copts->generate_unpack)
+	const bool columns = dbc_has_columns(dbc, copts);
+	if (columns && msg2h_columns_object(dbc, h, god, copts) < 0) {
+		rv = -1;
+		goto fail;
+	}
+
+	if (copts->generate_unpack) {
 		switch_function(h, dbc, "unpack", true, true, "uint64_t", true, god, copts);
+		fputs("\n/* Unpack \"n\" frames in order, the status of each is stored in \"status\", if it\n"
+			"   is not NULL, returns the number of frames unpacked without error */\n", h);
+		switch_function_batch(h, dbc, true, god, copts);
+		fputs("\n", h);
+	}
+
+	if (columns) {
+		fputs("/* Append a row for a frame to the columns of its message, the time stamp and\n"
+			"   the value of each signal are stored as \"decode_...\" would give them but\n"
+			"   without a range check, and whatever the value of any multiplexor */\n", h);
+		switch_function_columns(h, dbc, true, god, copts);
+		fputs("\n", h);
+	}
 
 	if (copts->generate_pack) {
 		switch_function(h, dbc, "pack", false, true, "uint64_t", false, god, copts);
@@ -1182,10 +2703,21 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 	if (copts->generate_print)
 		switch_function_print(h, dbc, true, god, copts);
 
+	if (copts->generate_unpack || copts->generate_pack)
+		fputs("\n/* Pack and unpack messages from bytes as they are on the bus, CAN-FD messages\n"
+			"   are only handled by these. \"data\" must have room for eight bytes, or\n"
+			"   64 if there are CAN-FD messages, and \"length\" is in bytes, not a DLC */\n", h);
+	if (copts->generate_unpack)
+		switch_function_bytes(h, dbc, true, true, god, copts);
+	if (copts->generate_pack)
+		switch_function_bytes(h, dbc, false, true, god, copts);
+	if (fd)
+		fputs(hfunctions_fd, h);
+
 	fputs("\n", h);
 
 	for (size_t i = 0; i < dbc->message_count; i++)
-		if (msg2h(dbc->messages[i], h, copts, god) < 0)
+		if (msg2h(dbc->messages[i], h, dbc->bus_count > 0, copts, god) < 0)
 			return -1;
 
 	fputs(
@@ -1210,28 +2742,48 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 	if (fprintf(c, "#include \"%s\"\n", name) < 0) return -1;
 	if (fprintf(c, "#include <inttypes.h>\n") < 0) return -1;
 	if (dbc->use_float)
-		fprintf(c, "#include <math.h> /* uses macros NAN, INFINITY, signbit, no need for -lm */\n");
+		fprintf(c, "#include <float.h>\n#include <math.h> /* uses macros NAN, INFINITY, signbit, no need for -lm */\n");
 	if (copts->generate_asserts)
 		fprintf(c, "#include <assert.h>\n");
+	fprintf(c, "#include <string.h>\n");
 	fputc('\n', c);
 	fprintf(c, "#define UNUSED(X) ((void)(X))\n\n");
 	fputs(cfunctions, c);
+	fputs(cfunctions_bytes, c);
 	if (copts->generate_print)
 		fputs(cfunctions_print_only, c);
-
+	if (copts->generate_extract && copts->generate_unpack)
+		fputs(cfunctions_extract, c);
+	if (columns)
+		fputs(cfunctions_columns, c);
+	if (copts->fixed_point && (copts->generate_unpack || copts->generate_pack))
+		fputs(cfunctions_fixed, c);
+
+	if ((copts->generate_unpack || copts->generate_pack) && dbc->use_float)
+		fputs(float_ieee754, c);
 	if (copts->generate_unpack && dbc->use_float)
 		fputs(float_unpack, c);
 	if (copts->generate_pack && dbc->use_float)
 		fputs(float_pack, c);
 
 	for (size_t i = 0; i < dbc->message_count; i++)
-		if (msg2c(dbc->messages[i], c, copts, god) < 0) {
+		if (msg2c(dbc->messages[i], c, dbc->bus_count > 0, copts, god) < 0) {
 			rv = -1;
 			goto fail;
 		}
 
-	if (copts->generate_unpack)
+	if (dispatch_tables(c, dbc, copts) < 0) {
+		rv = -1;
+		goto fail;
+	}
+
+	if (copts->generate_unpack) {
 		switch_function(c, dbc, "unpack", true, false, "uint64_t", true, god, copts);
+		switch_function_batch(c, dbc, false, god, copts);
+	}
+
+	if (columns)
+		switch_function_columns(c, dbc, false, god, copts);
 
 	if (copts->generate_pack) {
 		switch_function(c, dbc, "pack", false, false, "uint64_t", false, god, copts);
@@ -1241,6 +2793,11 @@ int dbc2c(dbc_t *dbc, FILE *c, FILE *h, const char *name, dbc2c_options_t *copts
 	if (copts->generate_print)
 		switch_function_print(c, dbc, false, god, copts);
 
+	if (copts->generate_unpack)
+		switch_function_bytes(c, dbc, true, false, god, copts);
+	if (copts->generate_pack)
+		switch_function_bytes(c, dbc, false, false, god, copts);
+
 fail:
 	free(file_guard);
 	free(god);
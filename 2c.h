@@ -9,7 +9,26 @@ extern "C" {
 
 #include "can.h"
 #include <stdbool.h>
+#include <stdint.h>
 
+/* How the generated "unpack_message" and the like find the functions for a
+ * message given its identifier */
+typedef enum {
+	DBC2C_DISPATCH_SWITCH, /**< a switch with one case per message, the default */
+	DBC2C_DISPATCH_TABLE,  /**< a two level table, for standard (11-bit) identifiers only */
+	DBC2C_DISPATCH_HASH,   /**< a collision free hash of the identifiers */
+} dbc2c_dispatch_e;
+
+/* The type of the physical values "unpack_physical_..." gives, if any */
+typedef enum {
+	DBC2C_PHYSICAL_NONE,   /**< no "unpack_physical_..." functions, the default */
+	DBC2C_PHYSICAL_FLOAT,
+	DBC2C_PHYSICAL_DOUBLE,
+} dbc2c_physical_e;
+
+/* Any option added here that changes the output must also be added to the
+ * cache key in main.c, and GENERATOR_VERSION there changed along with the
+ * generated code */
 typedef struct {
 	bool use_id_in_name;
 	bool use_time_stamps;
@@ -17,6 +36,11 @@ typedef struct {
 	bool generate_print, generate_pack, generate_unpack;
 	bool generate_asserts;
 	bool generate_enum_can_ids;
+	bool generate_extract; /**< functions that decode one signal from many payloads */
+	bool generate_columns; /**< unpack messages into growing arrays, a column per signal */
+	dbc2c_dispatch_e dispatch;
+	dbc2c_physical_e physical;
+	uint64_t fixed_point; /**< denominator of the units of the fixed point functions, 0 for none */
 	int version;
 } dbc2c_options_t;
 
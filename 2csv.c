@@ -7,43 +7,48 @@
  */
 #include "2csv.h"
 #include "util.h"
+#include "compile.h"
 #include <assert.h>
 
-static int msg2csv(can_msg_t *msg, FILE *o)
+static int msg2csv(const compiled_t *c, const compiled_message_t *msg, FILE *o)
 {
+	assert(c);
 	assert(msg);
 	assert(o);
 
-	signal_t *multiplexor = NULL;
-	for (size_t i = 0; i < msg->signal_count; i++) {
+	const char *name = msg->message->name;
+	const compiled_signal_t *sigs = &c->signals[msg->first];
+	const compiled_meta_t *meta = &c->meta[msg->first];
+	bool multiplexor = false;
+	for (size_t i = 0; i < msg->count; i++) {
 		char sv[64];
 		const char *multi = "N/A";
-		signal_t *sig = msg->sigs[i];
-		if (sig->is_multiplexor) {
+		const compiled_signal_t *sig = &sigs[i];
+		if (sig->flags & COMPILED_MULTIPLEXOR) {
 			if (multiplexor) {
-				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", msg->name);
+				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", name);
 				return -1;
 			}
 			multi = "multiplexor";
 		}
-		if (sig->is_multiplexed) {
-			sprintf(sv, "%d", sig->switchval);
+		if (sig->flags & COMPILED_MULTIPLEXED) {
+			sprintf(sv, "%d", (int)sig->switchval);
 			multi = sv;
 		}
 
 		/* "MSG, ID, DLC, Signal, Start, Length, Endianess, Scaling, Offset, Minimum, Maximum, Signed, Units, Multiplexed */
-		fprintf(o, "%s, %lu, %u, ", msg->name, msg->id | ((unsigned long)msg->is_extended << 31) , msg->dlc);
-		fprintf(o, "%s, ", sig->name);
-		fprintf(o, "%u, ", sig->start_bit);
-		fprintf(o, "%u, ", sig->bit_length);
-		fprintf(o, "%s, ", sig->endianess == endianess_motorola_e ? "motorola" : "intel");
+		fprintf(o, "%s, %lu, %u, ", name, msg->id | ((unsigned long)msg->is_extended << 31) , msg->dlc);
+		fprintf(o, "%s, ", meta[i].name);
+		fprintf(o, "%u, ", (unsigned)sig->start_bit);
+		fprintf(o, "%u, ", (unsigned)sig->bit_length);
+		fprintf(o, "%s, ", sig->flags & COMPILED_MOTOROLA ? "motorola" : "intel");
 		fprintf(o, "%g, ", sig->scaling);
 		fprintf(o, "%g, ", sig->offset);
 		fprintf(o, "%g, ", sig->minimum);
 		fprintf(o, "%g, ", sig->maximum);
-		fprintf(o, "%s, ", sig->is_signed ? "true" : "false");
+		fprintf(o, "%s, ", sig->flags & COMPILED_SIGNED ? "true" : "false");
 		bool have_units = false;
-		const char *units = sig->units;
+		const char *units = meta[i].units;
 		for (size_t i = 0; units[i]; i++)
 			if (!isspace(units[i]))
 				have_units = true;
@@ -53,10 +58,10 @@ static int msg2csv(can_msg_t *msg, FILE *o)
 		fprintf(o, "%s, ", multi);
 
 		const char *floating = "no";
-		if (sig->is_floating) {
-			assert(sig->sigval == 1 || sig->sigval == 2);
-			floating = (sig->sigval == 1) ? "single" : "double";
-		}
+		if (sig->flags & COMPILED_FLOAT)
+			floating = "single";
+		if (sig->flags & COMPILED_DOUBLE)
+			floating = "double";
 
 		fprintf(o, "%s, ", floating);
 		fprintf(o, "\n");
@@ -69,10 +74,10 @@ int dbc2csv(dbc_t *dbc, FILE *output)
 {
 	assert(dbc);
 	assert(output);
+	const compiled_t *c = dbc_compile(dbc);
 	fprintf(output, "MSG, ID, DLC, Signal, Start, Length, Endianess, Scaling, Offset, Minimum, Maximum, Signed, Units, Multiplexed, Floating,\n");
-	for (size_t i = 0; i < dbc->message_count; i++)
-		if (msg2csv(dbc->messages[i], output) < 0)
+	for (size_t i = 0; i < c->message_count; i++)
+		if (msg2csv(c, &c->messages[i], output) < 0)
 			return -1;
 	return 0;
 }
-
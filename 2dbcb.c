@@ -0,0 +1,421 @@
+/* @brief Save a resolved database as a relocatable binary image, and load
+ * one back in without parsing, see 2dbcb.h.
+ * @copyright SUBLEQ LTD. (2025)
+ * @license MIT */
+#include "2dbcb.h"
+#include "util.h"
+#include "index.h"
+#include "layout.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DBCB_VERSION    (4u)
+#define DBCB_BYTE_ORDER (0x01020304u)
+#define DBCB_ALIGN      (sizeof(uint64_t))
+
+static const char dbcb_magic[8] = { 'D', 'B', 'C', 'B', '\r', '\n', 0x1A, '\n' };
+
+enum { DBC, MESSAGE, SIGNAL, VAL, VAL_ITEM, MUL_VAL, SIGVAL, LAYOUT, SIZES };
+
+static const uint32_t sizes[SIZES] = {
+	[DBC]      = sizeof(dbc_t),
+	[MESSAGE]  = sizeof(can_msg_t),
+	[SIGNAL]   = sizeof(signal_t),
+	[VAL]      = sizeof(val_list_t),
+	[VAL_ITEM] = sizeof(val_list_item_t),
+	[MUL_VAL]  = sizeof(mul_val_list_t),
+	[SIGVAL]   = sizeof(sigval_t),
+	[LAYOUT]   = sizeof(layout_t),
+};
+
+typedef struct {
+	char magic[8];
+	uint32_t version;      /**< DBCB_VERSION */
+	uint32_t byte_order;   /**< DBCB_BYTE_ORDER as written by the host */
+	uint32_t pointer_size;
+	uint32_t checksum;     /**< see "checksum", of everything after the header */
+	uint32_t sizes[SIZES]; /**< size of each structure in the image */
+	uint64_t length;       /**< length of the whole image */
+	uint64_t root;         /**< offset of the dbc_t */
+	uint64_t relocations;  /**< offset of the relocation table */
+	uint64_t relocation_count;
+	char generator[32];    /**< version of dbcc that wrote the image, for information only */
+} header_t;
+
+/* Images can be large so they are checksummed with hash64, which is much
+ * faster than FNV-1a, to detect corruption (not tampering). */
+static uint32_t checksum(const uint8_t *b, size_t length)
+{
+	const uint64_t h = hash64(b, length, 0);
+	return (uint32_t)(h ^ (h >> 32));
+}
+
+/* An image being built up in memory, objects are appended to it and
+ * pointers between them are linked up by offset, pointers into the image
+ * must not be held as it moves when it grows. */
+typedef struct {
+	uint8_t *b;
+	size_t used, max;
+	uint64_t *relocations; /**< offsets of each pointer in the image */
+	size_t relocation_count, relocation_max;
+	index_t *seen;         /**< offset in the image of each object written */
+	arena_t *arena;
+} image_t;
+
+static size_t put(image_t *m, const void *p, size_t size)
+{
+	assert(m);
+	const size_t at = (m->used + DBCB_ALIGN - 1) & ~(DBCB_ALIGN - 1);
+	if ((at + size) > m->max) {
+		size_t max = m->max ? m->max : 4096;
+		while (max < (at + size))
+			max *= 2;
+		m->b = reallocator(m->b, max);
+		m->max = max;
+	}
+	memset(m->b + m->used, 0, at - m->used);
+	if (p)
+		memcpy(m->b + at, p, size);
+	else
+		memset(m->b + at, 0, size);
+	m->used = at + size;
+	return at;
+}
+
+/* Point the pointer at offset "slot" in the image at offset "target", a
+ * target of zero is a NULL pointer which does not need relocating. */
+static void link_to(image_t *m, size_t slot, size_t target)
+{
+	assert(m);
+	assert((slot + sizeof(uintptr_t)) <= m->used);
+	const uintptr_t v = target;
+	memcpy(m->b + slot, &v, sizeof(v));
+	if (!target)
+		return;
+	if (m->relocation_count >= m->relocation_max) {
+		m->relocation_max = m->relocation_max ? m->relocation_max * 2 : 1024;
+		m->relocations = reallocator(m->relocations, m->relocation_max * sizeof(*m->relocations));
+	}
+	m->relocations[m->relocation_count++] = slot;
+}
+
+static size_t seen(image_t *m, const void *p)
+{
+	return (uintptr_t)index_find(m->seen, 0, p);
+}
+
+static void remember(image_t *m, const void *p, size_t at)
+{
+	assert(at);
+	(void)index_add(m->seen, 0, p, (void*)(uintptr_t)at);
+}
+
+#define LINK(M, AT, TYPE, FIELD, TARGET) link_to((M), (AT) + offsetof(TYPE, FIELD), (TARGET))
+
+static size_t image_string(image_t *m, const char *s)
+{
+	assert(m);
+	if (!s)
+		return 0;
+	size_t at = seen(m, s);
+	if (!at) {
+		at = put(m, s, strlen(s) + 1);
+		remember(m, s, at);
+	}
+	return at;
+}
+
+static size_t image_strings(image_t *m, char **s, size_t count)
+{
+	assert(m);
+	if (!s)
+		return 0;
+	const size_t at = put(m, NULL, count * sizeof(*s));
+	for (size_t i = 0; i < count; i++)
+		link_to(m, at + (i * sizeof(*s)), image_string(m, s[i]));
+	return at;
+}
+
+static size_t image_val(image_t *m, val_list_t *v)
+{
+	assert(m);
+	if (!v)
+		return 0;
+	size_t at = seen(m, v);
+	if (at)
+		return at;
+	at = put(m, v, sizeof(*v));
+	remember(m, v, at);
+	LINK(m, at, val_list_t, name, image_string(m, v->name));
+	if (!v->val_list_items)
+		return at;
+	const size_t items = put(m, NULL, v->val_list_item_count * sizeof(*v->val_list_items));
+	LINK(m, at, val_list_t, val_list_items, items);
+	for (size_t i = 0; i < v->val_list_item_count; i++) {
+		val_list_item_t *item = v->val_list_items[i];
+		const size_t it = put(m, item, sizeof(*item));
+		LINK(m, it, val_list_item_t, name, image_string(m, item->name));
+		link_to(m, items + (i * sizeof(item)), it);
+	}
+	return at;
+}
+
+static size_t image_mul_val(image_t *m, mul_val_list_t *v)
+{
+	assert(m);
+	if (!v)
+		return 0;
+	size_t at = seen(m, v);
+	if (at)
+		return at;
+	at = put(m, v, sizeof(*v));
+	remember(m, v, at);
+	LINK(m, at, mul_val_list_t, multiplexed, image_string(m, v->multiplexed));
+	LINK(m, at, mul_val_list_t, multiplexor, image_string(m, v->multiplexor));
+	return at;
+}
+
+static size_t image_sigval(image_t *m, sigval_t *v)
+{
+	assert(m);
+	assert(v);
+	const size_t at = put(m, v, sizeof(*v));
+	LINK(m, at, sigval_t, name, image_string(m, v->name));
+	return at;
+}
+
+static size_t image_signal(image_t *m, signal_t *s)
+{
+	assert(m);
+	if (!s)
+		return 0;
+	size_t at = seen(m, s);
+	if (at)
+		return at;
+	at = put(m, s, sizeof(*s));
+	remember(m, s, at);
+	LINK(m, at, signal_t, units,    image_string(m, s->units));
+	LINK(m, at, signal_t, name,     image_string(m, s->name));
+	LINK(m, at, signal_t, comment,  image_string(m, s->comment));
+	LINK(m, at, signal_t, ecus,     image_strings(m, s->ecus, s->ecu_count));
+	LINK(m, at, signal_t, val_list, image_val(m, s->val_list));
+	if (s->muxed) {
+		const size_t muxed = put(m, NULL, s->mul_num * sizeof(*s->muxed));
+		LINK(m, at, signal_t, muxed, muxed);
+		for (size_t i = 0; i < s->mul_num; i++)
+			link_to(m, muxed + (i * sizeof(*s->muxed)), image_signal(m, s->muxed[i]));
+	}
+	if (s->mux_vals) {
+		const size_t mux_vals = put(m, NULL, s->mul_num * sizeof(*s->mux_vals));
+		LINK(m, at, signal_t, mux_vals, mux_vals);
+		for (size_t i = 0; i < s->mul_num; i++)
+			link_to(m, mux_vals + (i * sizeof(*s->mux_vals)), image_mul_val(m, s->mux_vals[i]));
+	}
+	return at;
+}
+
+static size_t image_message(image_t *m, can_msg_t *c)
+{
+	assert(m);
+	assert(c);
+	const size_t at = put(m, c, sizeof(*c));
+	LINK(m, at, can_msg_t, name,    image_string(m, c->name));
+	LINK(m, at, can_msg_t, ecu,     image_string(m, c->ecu));
+	LINK(m, at, can_msg_t, comment, image_string(m, c->comment));
+	if (c->layout)
+		LINK(m, at, can_msg_t, layout, put(m, c->layout, sizeof(*c->layout)));
+	if (c->sigs) {
+		const size_t sigs = put(m, NULL, c->signal_count * sizeof(*c->sigs));
+		LINK(m, at, can_msg_t, sigs, sigs);
+		for (size_t i = 0; i < c->signal_count; i++)
+			link_to(m, sigs + (i * sizeof(*c->sigs)), image_signal(m, c->sigs[i]));
+	}
+	return at;
+}
+
+/* An upper bound on the number of objects that are looked up in "seen" */
+static size_t objects(const dbc_t *dbc)
+{
+	assert(dbc);
+	size_t n = 0;
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		const can_msg_t *c = dbc->messages[i];
+		n += 3;
+		for (size_t j = 0; j < c->signal_count; j++)
+			n += 4 + c->sigs[j]->ecu_count + (2 * c->sigs[j]->mul_num);
+	}
+	for (size_t i = 0; i < dbc->val_count; i++)
+		n += 2 + dbc->vals[i]->val_list_item_count;
+	n += 3 * dbc->mul_val_count;
+	n += dbc->sigval_count;
+	n += dbc->bus_count;
+	return n;
+}
+
+static void image_dbc(image_t *m, dbc_t *d)
+{
+	assert(m);
+	assert(d);
+	/* the dbc_t is rebuilt without any of the parts only used while
+	 * reading, they are created afresh by dbcb_load */
+	dbc_t copy = {
+		.use_float     = d->use_float,
+		.message_count = d->message_count,
+		.val_count     = d->val_count,
+		.mul_val_count = d->mul_val_count,
+		.sigval_count  = d->sigval_count,
+		.version       = d->version,
+		.bus_count     = d->bus_count,
+	};
+	const size_t at = put(m, &copy, sizeof(copy));
+	assert(at == sizeof(header_t));
+	if (d->vals) {
+		const size_t vals = put(m, NULL, d->val_count * sizeof(*d->vals));
+		LINK(m, at, dbc_t, vals, vals);
+		for (size_t i = 0; i < d->val_count; i++)
+			link_to(m, vals + (i * sizeof(*d->vals)), image_val(m, d->vals[i]));
+	}
+	if (d->mul_vals) {
+		const size_t mul_vals = put(m, NULL, d->mul_val_count * sizeof(*d->mul_vals));
+		LINK(m, at, dbc_t, mul_vals, mul_vals);
+		for (size_t i = 0; i < d->mul_val_count; i++)
+			link_to(m, mul_vals + (i * sizeof(*d->mul_vals)), image_mul_val(m, d->mul_vals[i]));
+	}
+	if (d->sigvals) {
+		const size_t sigvals = put(m, NULL, d->sigval_count * sizeof(*d->sigvals));
+		LINK(m, at, dbc_t, sigvals, sigvals);
+		for (size_t i = 0; i < d->sigval_count; i++)
+			link_to(m, sigvals + (i * sizeof(*d->sigvals)), image_sigval(m, d->sigvals[i]));
+	}
+	LINK(m, at, dbc_t, buses, image_strings(m, d->buses, d->bus_count));
+	if (d->messages) {
+		const size_t messages = put(m, NULL, d->message_count * sizeof(*d->messages));
+		LINK(m, at, dbc_t, messages, messages);
+		for (size_t i = 0; i < d->message_count; i++)
+			link_to(m, messages + (i * sizeof(*d->messages)), image_message(m, d->messages[i]));
+	}
+}
+
+int dbc2dbcb(dbc_t *d, FILE *output)
+{
+	assert(d);
+	assert(output);
+	image_t m = { .arena = arena_new(), };
+	m.seen = index_new(m.arena, objects(d));
+
+	(void)put(&m, NULL, sizeof(header_t));
+	image_dbc(&m, d);
+	const size_t relocations = put(&m, m.relocations, m.relocation_count * sizeof(*m.relocations));
+
+	header_t h = {
+		.version          = DBCB_VERSION,
+		.byte_order       = DBCB_BYTE_ORDER,
+		.pointer_size     = sizeof(void*),
+		.length           = m.used,
+		.root             = sizeof(header_t),
+		.relocations      = relocations,
+		.relocation_count = m.relocation_count,
+	};
+	memcpy(h.magic, dbcb_magic, sizeof(h.magic));
+	memcpy(h.sizes, sizes, sizeof(h.sizes));
+	strncpy(h.generator, DBCC_VERSION, sizeof(h.generator) - 1);
+	h.checksum = checksum(m.b + sizeof(h), m.used - sizeof(h));
+	memcpy(m.b, &h, sizeof(h));
+
+	debug("dbcb: %zu bytes, %zu relocations", m.used, m.relocation_count);
+	errno = 0;
+	const int r = fwrite(m.b, 1, m.used, output) == m.used ? 0 : -1;
+	if (r < 0)
+		warning("writing binary database failed: %s", emsg());
+	free(m.b);
+	free(m.relocations);
+	arena_delete(m.arena);
+	return r;
+}
+
+static int check(const mapping_t *m, const header_t *h)
+{
+	assert(m);
+	assert(h);
+	if (m->length < sizeof(*h) || memcmp(h->magic, dbcb_magic, sizeof(h->magic)))
+		return -1;
+	if (h->version != DBCB_VERSION) {
+		warning("binary database version %u is not supported (expected %u)", (unsigned)h->version, DBCB_VERSION);
+		return -1;
+	}
+	if (h->byte_order != DBCB_BYTE_ORDER || h->pointer_size != sizeof(void*) || memcmp(h->sizes, sizes, sizeof(sizes))) {
+		warning("binary database was written by an incompatible build of dbcc (%.*s)", (int)sizeof(h->generator), h->generator);
+		return -1;
+	}
+	if (h->length != m->length || h->root != sizeof(*h)
+			|| h->relocations > h->length || h->relocations % DBCB_ALIGN
+			|| h->relocation_count > ((h->length - h->relocations) / sizeof(uint64_t))) {
+		warning("binary database is truncated or corrupt");
+		return -1;
+	}
+	if (checksum((uint8_t*)m->data + sizeof(*h), m->length - sizeof(*h)) != h->checksum) {
+		warning("binary database checksum failed");
+		return -1;
+	}
+	return 0;
+}
+
+dbc_t *dbcb_load(const char *name)
+{
+	assert(name);
+	FILE *f = fopen(name, "rb");
+	if (!f) {
+		warning("open '%s': %s", name, emsg());
+		return NULL;
+	}
+	mapping_t m;
+	const int r = map_file_writable(f, &m);
+	fclose(f);
+	if (r < 0)
+		return NULL;
+
+	header_t h;
+	if (m.length >= sizeof(h))
+		memcpy(&h, m.data, sizeof(h));
+	if (m.length < sizeof(h) || check(&m, &h) < 0) {
+		warning("'%s' is not a usable binary database", name);
+		unmap_file(&m);
+		return NULL;
+	}
+
+	uint8_t *base = (uint8_t*)m.data;
+	for (uint64_t i = 0; i < h.relocation_count; i++) {
+		uint64_t at = 0;
+		uintptr_t v = 0;
+		memcpy(&at, base + h.relocations + (i * sizeof(at)), sizeof(at));
+		if (at % sizeof(v) || at < sizeof(h) || (at + sizeof(v)) > h.relocations)
+			goto corrupt;
+		memcpy(&v, base + at, sizeof(v));
+		if (v < sizeof(h) || v >= h.relocations)
+			goto corrupt;
+		v += (uintptr_t)base;
+		memcpy(base + at, &v, sizeof(v));
+	}
+
+	dbc_t *d = (dbc_t*)(base + h.root);
+	d->arena = arena_new();
+	d->symbols = intern_new(d->arena);
+	mapping_t *image = arena_allocate(d->arena, sizeof(*image));
+	*image = m;
+	d->image = image;
+	debug("dbcb: loaded %zu messages from '%s'", d->message_count, name);
+	return d;
+corrupt:
+	warning("'%s' has a corrupt relocation table", name);
+	unmap_file(&m);
+	return NULL;
+}
+
+bool is_dbcb_file(const char *name)
+{
+	assert(name);
+	const char *dot = strrchr(name, '.');
+	return dot && !strcmp(dot, ".dbcb");
+}
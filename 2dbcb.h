@@ -0,0 +1,30 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT */
+#ifndef _2DBCB_H
+#define _2DBCB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can.h"
+#include <stdbool.h>
+
+/* A ".dbcb" file is a resolved database saved as an image of the dbc_t and
+ * everything it points to, with pointers stored as offsets into the image
+ * and a table of where they are. Loading it maps the file in and adds the
+ * address it was mapped at to each of the pointers, there is no parsing.
+ *
+ * The image depends on the layout of the structures in can.h so it is only
+ * portable between builds of dbcc that agree on it, the header records the
+ * version of the format, the byte order and the size of each structure and
+ * a file that does not match is rejected. */
+
+int dbc2dbcb(dbc_t *dbc, FILE *output);
+dbc_t *dbcb_load(const char *name);
+bool is_dbcb_file(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -5,6 +5,7 @@
  */
 #include "2json.h"
 #include "util.h"
+#include "compile.h"
 #include <assert.h>
 #include <time.h>
 
@@ -67,29 +68,30 @@ warn:
 	return -1;
 }
 
-static int signal2json(signal_t *sig, FILE *o, unsigned depth, int multiplexed, int selector, int is_value)
+static int signal2json(const compiled_signal_t *sig, const compiled_meta_t *meta, FILE *o, unsigned depth, int multiplexed, int selector, int is_value)
 {
 	assert(sig);
+	assert(meta);
 	assert(o);
 	if (!is_value)
 		indent(o, depth);
 	fprintf(o, "{\n");
-	pfield(o, depth+1, false, STRING, "name",      "%s", sig->name);
-	pfield(o, depth+1, false, INT,    "startbit",  "%u", sig->start_bit);
-	pfield(o, depth+1, false, INT,    "bitlength", "%u", sig->bit_length);
-	pfield(o, depth+1, false, STRING, "endianess", "%s", sig->endianess == endianess_motorola_e ? "motorola" : "intel");
+	pfield(o, depth+1, false, STRING, "name",      "%s", meta->name);
+	pfield(o, depth+1, false, INT,    "startbit",  "%u", (unsigned)sig->start_bit);
+	pfield(o, depth+1, false, INT,    "bitlength", "%u", (unsigned)sig->bit_length);
+	pfield(o, depth+1, false, STRING, "endianess", "%s", sig->flags & COMPILED_MOTOROLA ? "motorola" : "intel");
 	pfield(o, depth+1, false, FLOAT,  "scaling",   "%g", sig->scaling);
 	pfield(o, depth+1, false, FLOAT,  "offset",    "%g", sig->offset);
 	pfield(o, depth+1, false, FLOAT,  "minimum",   "%g", sig->minimum);
 	pfield(o, depth+1, false, FLOAT,  "maximum",   "%g", sig->maximum);
-	pfield(o, depth+1, false, BOOL,   "signed",    "%s", sig->is_signed ? "true" : "false");
-	pfield(o, depth+1, false, INT,    "floating",  "%u", sig->is_floating ? sig->sigval : 0);
+	pfield(o, depth+1, false, BOOL,   "signed",    "%s", sig->flags & COMPILED_SIGNED ? "true" : "false");
+	pfield(o, depth+1, false, INT,    "floating",  "%u", compiled_floating(sig));
 	if (multiplexed)
 		pfield(o, depth+1, false, STRING, "selector",      "%u", selector);
 
 	indent(o, depth+1);
 	fprintf(o, "\"units\" : \"");
-	print_escaped(o, sig->units);
+	print_escaped(o, meta->units);
 	fprintf(o, "\"\n");
 
 	indent(o, depth);
@@ -98,64 +100,66 @@ static int signal2json(signal_t *sig, FILE *o, unsigned depth, int multiplexed,
 	return 0;
 }
 
-static int msg2json(can_msg_t *msg, FILE *o, unsigned depth)
+static int msg2json(const compiled_t *c, const compiled_message_t *msg, FILE *o, unsigned depth)
 {
+	assert(c);
 	assert(msg);
 	assert(o);
+	const char *name = msg->message->name;
+	const compiled_signal_t *sigs = &c->signals[msg->first];
+	const compiled_meta_t *meta = &c->meta[msg->first];
 	indent(o, depth);
 	fprintf(o, "{\n");
-	pfield(o, depth+1, false, STRING, "name",      "%s", msg->name);
-	pfield(o, depth+1, false, INT,    "id",        "%u", msg->id);
+	pfield(o, depth+1, false, STRING, "name",      "%s", name);
+	pfield(o, depth+1, false, INT,    "id",        "%lu", msg->id);
 	pfield(o, depth+1, false, BOOL,   "extended",  "%s", msg->is_extended ? "true" : "false");
 	pfield(o, depth+1, false, INT,    "dlc",       "%u", msg->dlc);
 
-	signal_t *multiplexor = NULL;
+	size_t multiplexor = SIZE_MAX;
 	indent(o, depth+1);
 	fprintf(o, "\"signals\": [\n");
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *sig = msg->sigs[i];
-		if (sig->is_multiplexor) {
-			if (multiplexor) {
-				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", msg->name);
+	for (size_t i = 0; i < msg->count; i++) {
+		const compiled_signal_t *sig = &sigs[i];
+		if (sig->flags & COMPILED_MULTIPLEXOR) {
+			if (multiplexor != SIZE_MAX) {
+				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", name);
 				return -1;
 			}
-			multiplexor = sig;
+			multiplexor = i;
 			continue;
 		}
-		if (sig->is_multiplexed)
+		if (sig->flags & COMPILED_MULTIPLEXED)
 			continue;
-		if (signal2json(sig, o, depth+2, 0, 0, 0) < 0)
+		if (signal2json(sig, &meta[i], o, depth+2, 0, 0, 0) < 0)
 			return -1;
-		if ((msg->signal_count && i < (msg->signal_count - 1)))// || multiplexor)
+		if ((msg->count && i < (msg->count - 1)))// || multiplexor)
 			fprintf(o, ",");
 		fprintf(o, "\n");
 	}
 	indent(o, depth+1);
-	fprintf(o, "]%s\n", multiplexor ? "," : "");
+	fprintf(o, "]%s\n", multiplexor != SIZE_MAX ? "," : "");
 
-	if (multiplexor) {
+	if (multiplexor != SIZE_MAX) {
 		indent(o, depth+1);
 		fprintf(o, "\"multiplexor-group\" : {\n");
 		indent(o, depth+2);
 		fprintf(o, "\"multiplexor\" : ");
-		if (signal2json(multiplexor, o, depth+3, 0, 0, 1) < 0)
+		if (signal2json(&sigs[multiplexor], &meta[multiplexor], o, depth+3, 0, 0, 1) < 0)
 			return -1;
-		fprintf(o, "%s\n", msg->signal_count ? "," : "");
+		fprintf(o, "%s\n", msg->count ? "," : "");
 		size_t multiplexed_count = 0;
-		for (size_t i = 0; i < msg->signal_count; i++) {
-			signal_t *sig = msg->sigs[i];
-			if (sig->is_multiplexed)
+		for (size_t i = 0; i < msg->count; i++)
+			if (sigs[i].flags & COMPILED_MULTIPLEXED)
 				multiplexed_count++;
-		}
 
 		indent(o, depth+2);
 		fprintf(o, "\"multiplexed\" : [\n");
-		for (size_t i = 0, j = 0; i < msg->signal_count; i++) {
-			signal_t *sig = msg->sigs[i];
-			if (!(sig->is_multiplexed))
+		for (size_t i = 0, j = 0; i < msg->count; i++) {
+			const compiled_signal_t *sig = &sigs[i];
+			if (!(sig->flags & COMPILED_MULTIPLEXED))
 				continue;
 			j++;
-			if (signal2json(sig, o, depth+3, 1, sig->switchval, 0) < 0)
+			if (signal2json(sig, &meta[i], o, depth+3, 1, sig->switchval, 0) < 0)
 				return -1;
 			if (multiplexed_count && j < multiplexed_count)
 				fprintf(o, ",");
@@ -189,11 +193,12 @@ int dbc2json(dbc_t *dbc, FILE *output, bool use_time_stamps)
 	if (use_time_stamps)
 		fprintf(output, "\t\"generated-on\": %s,", asctime(timeinfo));
 
+	const compiled_t *c = dbc_compile(dbc);
 	fprintf(output, "\t\"messages\" : [\n");
-	for (size_t i = 0; i < dbc->message_count; i++) {
-		if (msg2json(dbc->messages[i], output, 2) < 0)
+	for (size_t i = 0; i < c->message_count; i++) {
+		if (msg2json(c, &c->messages[i], output, 2) < 0)
 			return -1;
-		if (dbc->message_count && i < (dbc->message_count - 1))
+		if (c->message_count && i < (c->message_count - 1))
 			fprintf(output, ",");
 		fprintf(output, "\n");
 	}
@@ -5,6 +5,7 @@
  */
 #include "2xml.h"
 #include "util.h"
+#include "compile.h"
 #include <assert.h>
 #include <time.h>
 
@@ -97,27 +98,28 @@ warn:
 	return -1;
 }
 
-static int signal2xml(signal_t *sig, FILE *o, unsigned depth)
+static int signal2xml(const compiled_signal_t *sig, const compiled_meta_t *meta, FILE *o, unsigned depth)
 {
 	assert(sig);
+	assert(meta);
 	assert(o);
 	indent(o, depth);
 	fprintf(o, "<signal>\n");
-	pnode(o, depth+1, "name",      "%s", sig->name);
-	pnode(o, depth+1, "startbit",  "%u", sig->start_bit);
-	pnode(o, depth+1, "bitlength", "%u", sig->bit_length);
-	pnode(o, depth+1, "endianess", "%s", sig->endianess == endianess_motorola_e ? "motorola" : "intel");
+	pnode(o, depth+1, "name",      "%s", meta->name);
+	pnode(o, depth+1, "startbit",  "%u", (unsigned)sig->start_bit);
+	pnode(o, depth+1, "bitlength", "%u", (unsigned)sig->bit_length);
+	pnode(o, depth+1, "endianess", "%s", sig->flags & COMPILED_MOTOROLA ? "motorola" : "intel");
 	pnode(o, depth+1, "scaling",   "%g", sig->scaling);
 	pnode(o, depth+1, "offset",    "%g", sig->offset);
 	pnode(o, depth+1, "minimum",   "%g", sig->minimum);
 	pnode(o, depth+1, "maximum",   "%g", sig->maximum);
-	pnode(o, depth+1, "signed",    "%s", sig->is_signed ? "true" : "false");
-	pnode(o, depth+1, "floating",  "%u", sig->is_floating ? sig->sigval : 0);
+	pnode(o, depth+1, "signed",    "%s", sig->flags & COMPILED_SIGNED ? "true" : "false");
+	pnode(o, depth+1, "floating",  "%u", compiled_floating(sig));
 
 	indent(o, depth+1);
 	fprintf(o, "<units>");
 	/*indent(o, depth+2);*/
-	print_escaped(o, sig->units);
+	print_escaped(o, meta->units);
 	/*indent(o, depth+1);*/
 	fprintf(o, "</units>\n");
 
@@ -127,52 +129,56 @@ static int signal2xml(signal_t *sig, FILE *o, unsigned depth)
 	return 0;
 }
 
-static int msg2xml(can_msg_t *msg, FILE *o, unsigned depth)
+static int msg2xml(const compiled_t *c, const compiled_message_t *msg, FILE *o, unsigned depth)
 {
+	assert(c);
 	assert(msg);
 	assert(o);
+	const char *name = msg->message->name;
+	const compiled_signal_t *sigs = &c->signals[msg->first];
+	const compiled_meta_t *meta = &c->meta[msg->first];
 	indent(o, depth);
 	fprintf(o, "<message>\n");
-	pnode(o, depth+1, "name", "%s", msg->name);
-	pnode(o, depth+1, "id",   "%u", msg->id);
+	pnode(o, depth+1, "name", "%s", name);
+	pnode(o, depth+1, "id",   "%lu", msg->id);
 	pnode(o, depth+1, "dlc",  "%u", msg->dlc);
 	pnode(o, depth+1, "extended",  "%d", (int)msg->is_extended);
 
-	signal_t *multiplexor = NULL;
-	for (size_t i = 0; i < msg->signal_count; i++) {
-		signal_t *sig = msg->sigs[i];
-		if (sig->is_multiplexor) {
-			if (multiplexor) {
-				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", msg->name);
+	size_t multiplexor = SIZE_MAX;
+	for (size_t i = 0; i < msg->count; i++) {
+		const compiled_signal_t *sig = &sigs[i];
+		if (sig->flags & COMPILED_MULTIPLEXOR) {
+			if (multiplexor != SIZE_MAX) {
+				error("multiple multiplexor values detected (only one per CAN msg is allowed) for %s", name);
 				return -1;
 			}
-			multiplexor = sig;
+			multiplexor = i;
 			continue;
 		}
-		if (sig->is_multiplexed)
+		if (sig->flags & COMPILED_MULTIPLEXED)
 			continue;
-		if (signal2xml(sig, o, depth+1) < 0)
+		if (signal2xml(sig, &meta[i], o, depth+1) < 0)
 			return -1;
 	}
 
-	if (multiplexor) {
+	if (multiplexor != SIZE_MAX) {
 		indent(o, depth+1);
 		fprintf(o, "<multiplexor-group>\n");
 		indent(o, depth+2);
 		fprintf(o, "<multiplexor>\n");
-		if (signal2xml(multiplexor, o, depth+2) < 0)
+		if (signal2xml(&sigs[multiplexor], &meta[multiplexor], o, depth+2) < 0)
 			return -1;
 		indent(o, depth+2);
 		fprintf(o, "</multiplexor>\n");
 
-		for (size_t i = 0; i < msg->signal_count; i++) {
-			signal_t *sig = msg->sigs[i];
-			if (!(sig->is_multiplexed))
+		for (size_t i = 0; i < msg->count; i++) {
+			const compiled_signal_t *sig = &sigs[i];
+			if (!(sig->flags & COMPILED_MULTIPLEXED))
 				continue;
 			indent(o, depth+2);
 			fprintf(o, "<multiplexed>\n");
-			pnode(o, depth+3, "multiplexed-on", "%u",  sig->switchval);
-			if (signal2xml(sig, o, depth+3) < 0)
+			pnode(o, depth+3, "multiplexed-on", "%u", (unsigned)sig->switchval);
+			if (signal2xml(sig, &meta[i], o, depth+3) < 0)
 				return -1;
 			indent(o, depth+2);
 			fprintf(o, "</multiplexed>\n");
@@ -202,9 +208,10 @@ int dbc2xml(dbc_t *dbc, FILE *output, bool use_time_stamps)
 	if (use_time_stamps)
 		comment(output, 0, "Generated on: %s", asctime(timeinfo));
 
+	const compiled_t *c = dbc_compile(dbc);
 	fprintf(output, "<candb>\n");
-	for (size_t i = 0; i < dbc->message_count; i++)
-		if (msg2xml(dbc->messages[i], output, 1) < 0)
+	for (size_t i = 0; i < c->message_count; i++)
+		if (msg2xml(c, &c->messages[i], output, 1) < 0)
 			return -1;
 	if (fprintf(output, "</candb>\n") < 0)
 		return -1;
@@ -0,0 +1,155 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief A simple region based allocator, used for everything owned by a
+ * dbc_t so it can be torn down in one go. */
+#include "arena.h"
+#include "util.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE (64u * 1024u)
+#define ARENA_MIN_ARRAY  (1u)
+
+typedef union {
+	long double ld;
+	void *p;
+	uint64_t u;
+	void (*fn)(void);
+} align_t;
+
+typedef struct block_t block_t;
+
+struct block_t {
+	block_t *next;  /**< next (older) block */
+	size_t size;    /**< usable bytes in this block */
+	size_t used;    /**< bytes handed out */
+	align_t data[]; /**< data, aligned for any type */
+};
+
+struct arena_t {
+	block_t *head;       /**< block currently being allocated from */
+	size_t allocations;  /**< number of allocations made */
+	size_t requested;    /**< bytes requested by callers */
+	size_t reserved;     /**< bytes requested from the system */
+	size_t blocks;       /**< number of blocks */
+	size_t grows;        /**< number of times an array has been grown */
+};
+
+static block_t *block_new(arena_t *a, size_t size)
+{
+	assert(a);
+	block_t *b = allocate(sizeof(*b) + size);
+	b->size = size;
+	a->reserved += size;
+	a->blocks++;
+	return b;
+}
+
+arena_t *arena_new(void)
+{
+	return allocate(sizeof(arena_t));
+}
+
+void arena_delete(arena_t *a)
+{
+	if (!a)
+		return;
+	debug("arena: %zu allocations, %zu bytes requested, %zu grows, %zu bytes in %zu blocks",
+			a->allocations, a->requested, a->grows, a->reserved, a->blocks);
+	for (block_t *b = a->head, *n = NULL; b; b = n) {
+		n = b->next;
+		free(b);
+	}
+	free(a);
+}
+
+void *arena_allocate(arena_t *a, size_t size)
+{
+	assert(a);
+	const size_t align = sizeof(align_t);
+	const size_t rounded = size + ((align - (size % align)) % align);
+	if (rounded < size)
+		error("arena allocation too large: %zu", size);
+	a->allocations++;
+	a->requested += size;
+	block_t *b = a->head;
+	if (!b || (b->size - b->used) < rounded) {
+		if (rounded > (ARENA_BLOCK_SIZE / 4)) {
+			/* large allocations get their own block, which goes
+			 * behind the head so the head can still be used. */
+			block_t *l = block_new(a, rounded);
+			l->used = rounded;
+			if (b) {
+				l->next = b->next;
+				b->next = l;
+			} else {
+				a->head = l;
+			}
+			return l->data;
+		}
+		b = block_new(a, ARENA_BLOCK_SIZE);
+		b->next = a->head;
+		a->head = b;
+	}
+	void *r = (char*)b->data + b->used;
+	b->used += rounded;
+	return r;
+}
+
+char *arena_duplicate_n(arena_t *a, const char *s, size_t length)
+{
+	assert(a);
+	assert(s);
+	char *r = arena_allocate(a, length + 1);
+	memcpy(r, s, length);
+	return r;
+}
+
+char *arena_duplicate(arena_t *a, const char *s)
+{
+	assert(a);
+	assert(s);
+	return arena_duplicate_n(a, s, strlen(s));
+}
+
+void *arena_grow(arena_t *a, void *p, size_t count, size_t size)
+{
+	assert(a);
+	assert(count == 0 || p);
+	if (count == 0)
+		return arena_allocate(a, ARENA_MIN_ARRAY * size);
+	if (count < ARENA_MIN_ARRAY || !is_power_of_two(count))
+		return p;
+	if (((count * 2) / 2) != count || ((count * 2 * size) / size) != (count * 2))
+		error("arena array too large: %zu", count);
+	void *r = arena_allocate(a, count * 2 * size);
+	memcpy(r, p, count * size);
+	a->grows++;
+	return r;
+}
+
+void arena_adopt(arena_t *a, arena_t *from)
+{
+	assert(a);
+	assert(from);
+	assert(a != from);
+	block_t *tail = from->head;
+	if (tail) {
+		while (tail->next)
+			tail = tail->next;
+		/* keep the head of "a", as it is the block being allocated from */
+		if (a->head) {
+			tail->next = a->head->next;
+			a->head->next = from->head;
+		} else {
+			a->head = from->head;
+		}
+	}
+	a->allocations += from->allocations;
+	a->requested   += from->requested;
+	a->reserved    += from->reserved;
+	a->blocks      += from->blocks;
+	a->grows       += from->grows;
+	free(from);
+}
@@ -0,0 +1,37 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef ARENA_H
+#define ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/* A region allocator, allocations are bumped out of large blocks and are all
+ * released at once with arena_delete, there is no way to free an individual
+ * allocation. All memory returned is zeroed. */
+typedef struct arena_t arena_t;
+
+arena_t *arena_new(void);
+void arena_delete(arena_t *a);
+void *arena_allocate(arena_t *a, size_t size);
+char *arena_duplicate(arena_t *a, const char *s);
+char *arena_duplicate_n(arena_t *a, const char *s, size_t length);
+
+/* Grow an array of "count" elements each of "size" bytes so another element
+ * can be appended, the capacity is implied by the count so it does not need
+ * to be stored: arrays are grown geometrically. "p" must be NULL if "count"
+ * is zero, and must have been returned by arena_grow otherwise. */
+void *arena_grow(arena_t *a, void *p, size_t count, size_t size);
+
+/* Move all of the memory owned by "from" into "a" and delete "from", the
+ * memory stays where it is so pointers into "from" remain valid. */
+void arena_adopt(arena_t *a, arena_t *from);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/* Frames per second decoded from a log of frames for the messages in
+ * bench/bench.dbc with "unpack_messages", which finds the message once for
+ * each run of frames with the same identifier, and with "unpack_message" for
+ * each frame. The log is decoded RUNS times, 100 million frames in all, once
+ * with the messages interleaved and once sorted into runs of up to RUN
+ * frames. Both ways must give the same status for each frame and the same
+ * decoded messages. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef FRAMES
+#define FRAMES (1u << 20)
+#endif
+#ifndef RUNS
+#define RUNS   (100)
+#endif
+#ifndef RUN
+#define RUN    (64)
+#endif
+
+static const unsigned long ids[] = { 0x100, 0x200, 0x300, 0x7ff, /* not in the database */ };
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+static void make_log(dbcc_frame_t *frames, size_t n, unsigned run)
+{
+	for (size_t i = 0; i < n;) {
+		const unsigned long id = ids[random_u64() % (sizeof(ids) / sizeof(ids[0]))];
+		const size_t length = run > 1 ? 1 + random_u64() % run : 1;
+		for (size_t j = 0; j < length && i < n; j++, i++) {
+			frames[i].data = random_u64();
+			frames[i].id = id;
+			frames[i].time_stamp = i;
+			frames[i].dlc = 8;
+			frames[i].bus = 0;
+		}
+	}
+}
+
+/* Returns the number of frames whose status differs between the two ways */
+static unsigned long compare(const char *name, const dbcc_frame_t *frames)
+{
+	static can_obj_bench_h_t o, p;
+	static int status[FRAMES];
+	volatile size_t sink = 0;
+	unsigned long bad = 0;
+	sink += unpack_messages(&o, frames, FRAMES, status);
+	for (size_t i = 0; i < FRAMES; i++)
+		bad += unpack_message(&p, frames[i].id, frames[i].data, frames[i].dlc, frames[i].time_stamp) != status[i];
+	bad += memcmp(&o, &p, sizeof(o)) != 0;
+
+	double batch = 0, single = 0;
+	for (int r = 0; r < RUNS; r++) {
+		const double t0 = now();
+		sink += unpack_messages(&o, frames, FRAMES, NULL);
+		const double t1 = now();
+		for (size_t i = 0; i < FRAMES; i++)
+			sink += unpack_message(&p, frames[i].id, frames[i].data, frames[i].dlc, frames[i].time_stamp);
+		const double t2 = now();
+		batch += t1 - t0;
+		single += t2 - t1;
+	}
+	const double total = (double)FRAMES * RUNS;
+	printf("%-12s %16.0f %16.0f %8.2f\n", name, total / batch, total / single, single / batch);
+	return bad;
+}
+
+int main(void)
+{
+	static dbcc_frame_t frames[FRAMES];
+	unsigned long bad = 0;
+	printf("%-12s %16s %16s %8s (frames per second, %.0f frames)\n", "log", "unpack_messages", "unpack_message", "speedup", (double)FRAMES * RUNS);
+	make_log(frames, FRAMES, 1);
+	bad += compare("interleaved", frames);
+	make_log(frames, FRAMES, RUN);
+	bad += compare("runs", frames);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
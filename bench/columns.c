@@ -0,0 +1,96 @@
+/* Throughput of decoding a log of frames into a column for each signal, with
+ * "unpack_columns" and with "unpack_message" and "decode_..." a frame at a
+ * time, the two must give the same values. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef FRAMES
+#define FRAMES (1u << 14) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS   (100)
+#endif
+
+#define WHEELS(X)\
+	X(0x100, WheelSpeeds, WheelSpeedFL, dbcc_double_t)\
+	X(0x100, WheelSpeeds, WheelSpeedFR, dbcc_double_t)\
+	X(0x100, WheelSpeeds, WheelSpeedRL, dbcc_double_t)\
+	X(0x100, WheelSpeeds, WheelSpeedRR, dbcc_double_t)
+
+#define ENGINE(X)\
+	X(0x200, Engine, Torque,      dbcc_double_t)\
+	X(0x200, Engine, Odometer,    dbcc_double_t)\
+	X(0x200, Engine, CoolantTemp, dbcc_double_t)\
+	X(0x200, Engine, OilPressure, dbcc_double_t)\
+	X(0x200, Engine, Gear,        uint8_t)
+
+#define COLUMN(ID, MSG, SIGNAL, TYPE) static TYPE SIGNAL[FRAMES];
+#define DECODE(ID, MSG, SIGNAL, TYPE) bad += decode_can_##ID##_##SIGNAL(&o, &SIGNAL[row]) < 0;
+#define COMPARE(ID, MSG, SIGNAL, TYPE) same = same && !memcmp(SIGNAL, c.can_##ID##_##MSG.SIGNAL, c.can_##ID##_##MSG.count * sizeof(TYPE));
+
+typedef struct {
+	uint64_t data;
+	unsigned long id;
+} frame_t;
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(void)
+{
+	static can_obj_bench_h_t o;
+	static can_columns_bench_h_t c;
+	static frame_t frames[FRAMES];
+	WHEELS(COLUMN)
+	ENGINE(COLUMN)
+	int bad = 0, same = 1;
+	double each = 1e9, columns = 1e9;
+	for (size_t i = 0; i < FRAMES; i++) {
+		frames[i].data = random_u64();
+		frames[i].id = random_u64() & 1 ? 0x100 : 0x200;
+	}
+	for (int r = 0; r < RUNS; r++) {
+		size_t wheels = 0, engine = 0;
+		const double t0 = now();
+		for (size_t i = 0; i < FRAMES; i++) {
+			bad += unpack_message(&o, frames[i].id, frames[i].data, 8, 0) < 0;
+			if (frames[i].id == 0x100) {
+				const size_t row = wheels++;
+				WHEELS(DECODE)
+			} else {
+				const size_t row = engine++;
+				ENGINE(DECODE)
+			}
+		}
+		const double t1 = now();
+		clear_columns(&c);
+		for (size_t i = 0; i < FRAMES; i++)
+			bad += unpack_columns(&c, frames[i].id, frames[i].data, 8, i) < 0;
+		const double t2 = now();
+		each = t1 - t0 < each ? t1 - t0 : each;
+		columns = t2 - t1 < columns ? t2 - t1 : columns;
+	}
+	WHEELS(COMPARE)
+	ENGINE(COMPARE)
+	free_columns(&c);
+	printf("%-14s %8s %8s (million frames per second)\n", "", "each", "columns");
+	printf("%-14s %8.1f %8.1f %6.1fx %s\n", "frames", FRAMES / each / 1e6, FRAMES / columns / 1e6, each / columns, same ? "" : "(DIFFERENT)");
+	return bad || !same;
+}
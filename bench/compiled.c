@@ -0,0 +1,89 @@
+/* The raw value of every signal in each DBC file given, extracted from
+ * random payloads with "compiled_raw" and "compiled_raw_bytes", must be the
+ * same as one worked out a bit at a time from the bit numbering of the DBC
+ * format. See "make compiled". */
+#include "compile.h"
+#include "read.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef PAYLOADS
+#define PAYLOADS (1000)
+#endif
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+/* Intel signals count up from their least significant bit, Motorola ones
+ * count down from their most significant bit, to the end of each byte and
+ * then to the most significant bit of the next. "last" is set to the highest
+ * byte the signal uses. */
+static uint64_t reference(const signal_t *sig, const uint8_t *data, unsigned *last)
+{
+	uint64_t x = 0;
+	unsigned bit = sig->start_bit;
+	*last = 0;
+	for (unsigned i = 0; i < sig->bit_length; i++) {
+		const unsigned k = sig->endianess == endianess_motorola_e ? sig->bit_length - 1 - i : i;
+		*last = bit / 8 > *last ? bit / 8 : *last;
+		x |= (uint64_t)((data[bit / 8] >> (bit % 8)) & 1u) << k;
+		if (sig->endianess != endianess_motorola_e)
+			bit++;
+		else if (bit % 8 == 0)
+			bit += 15;
+		else
+			bit--;
+	}
+	if (sig->is_signed && !sig->is_floating && sig->bit_length && sig->bit_length < 64 && (x >> (sig->bit_length - 1)) & 1)
+		x |= ~compiled_mask(sig->bit_length);
+	return x;
+}
+
+static unsigned long check(const char *file, const compiled_meta_t *meta, const char *function, uint64_t raw, uint64_t expect)
+{
+	if (raw == expect)
+		return 0;
+	fprintf(stderr, "%s: %s of signal %s is %llx not %llx\n", file, function, meta->name, (unsigned long long)raw, (unsigned long long)expect);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long checks = 0, bad = 0;
+	for (int i = 1; i < argc; i++) {
+		dbc_t *dbc = read_dbc_file_by_name(argv[i]);
+		if (!dbc) {
+			fprintf(stderr, "could not read %s\n", argv[i]);
+			return 1;
+		}
+		const compiled_t *c = dbc_compile(dbc);
+		for (unsigned p = 0; p < PAYLOADS; p++) {
+			uint8_t data[64] = { 0, };
+			uint64_t word = 0;
+			for (unsigned b = 0; b < sizeof(data); b++)
+				data[b] = random_u64() >> 56;
+			for (unsigned b = 0; b < 8; b++)
+				word |= (uint64_t)data[b] << (8 * b);
+			for (size_t j = 0; j < c->signal_count; j++) {
+				unsigned last = 0;
+				const compiled_signal_t *s = &c->signals[j];
+				const uint64_t expect = reference(c->meta[j].signal, data, &last);
+				checks++;
+				bad += check(argv[i], &c->meta[j], "compiled_raw_bytes", compiled_raw_bytes(s, data, last + 1), expect);
+				if (s->flags & COMPILED_FD)
+					continue;
+				checks++;
+				bad += last >= 8 || check(argv[i], &c->meta[j], "compiled_raw", compiled_raw(s, word), expect);
+			}
+		}
+		dbc_delete(dbc);
+	}
+	printf("compiled_raw and compiled_raw_bytes: %lu checks, %lu wrong\n", checks, bad);
+	return bad != 0 || checks == 0;
+}
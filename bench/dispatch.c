@@ -0,0 +1,100 @@
+/* Time taken to find and unpack the message of each frame with
+ * "unpack_message", for random identifiers of the messages in the DBC file
+ * given, which was made by bench/generate.c. This is compiled once for each
+ * '-O dispatch=...' mode, each frame of a known message must unpack and each
+ * unknown identifier must not. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "ids.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef FRAMES
+#define FRAMES (1u << 16) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS   (50)
+#endif
+#ifndef MODE
+#define MODE   "switch"
+#endif
+
+typedef struct {
+	uint64_t data;
+	unsigned long id;
+} frame_t;
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+	static can_obj_ids_h_t o;
+	static frame_t frames[FRAMES];
+	static unsigned long ids[1ul << 16];
+	size_t n = 0;
+	char line[256];
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s file.dbc\n", argv[0]);
+		return 1;
+	}
+	FILE *dbc = fopen(argv[1], "rb");
+	if (!dbc) {
+		fprintf(stderr, "could not open %s\n", argv[1]);
+		return 1;
+	}
+	while (n < sizeof(ids) / sizeof(ids[0]) && fgets(line, sizeof(line), dbc))
+		if (sscanf(line, "BO_ %lu", &ids[n]) == 1)
+			ids[n++] &= 0x7ffffffful; /* extended identifiers have the top bit set */
+	fclose(dbc);
+	if (!n) {
+		fprintf(stderr, "no messages in %s\n", argv[1]);
+		return 1;
+	}
+
+	unsigned long bad = 0, largest = 0;
+	for (size_t i = 0; i < n; i++) {
+		bad += unpack_message(&o, ids[i], random_u64(), 8, 0) < 0;
+		largest = ids[i] > largest ? ids[i] : largest;
+	}
+	const unsigned long mask = largest < (1ul << 11) ? (1ul << 11) - 1 : (1ul << 29) - 1;
+	for (size_t i = 0; i < n; i++) { /* identifiers in the same range not in the file */
+		const unsigned long id = random_u64() & mask;
+		size_t j = 0;
+		for (; j < n && ids[j] != id; j++)
+			;
+		bad += j == n && unpack_message(&o, id, random_u64(), 8, 0) >= 0;
+	}
+	for (size_t i = 0; i < FRAMES; i++) {
+		frames[i].id = ids[random_u64() % n];
+		frames[i].data = random_u64();
+	}
+
+	double best = 1e9;
+	volatile long sink = 0;
+	for (int r = 0; r < RUNS; r++) {
+		const double t0 = now();
+		for (size_t i = 0; i < FRAMES; i++)
+			sink += unpack_message(&o, frames[i].id, frames[i].data, 8, 0);
+		const double t = now() - t0;
+		best = t < best ? t : best;
+	}
+	printf("%-8s %6zu messages %8.1f nanoseconds per frame\n", MODE, n, best / FRAMES * 1e9);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
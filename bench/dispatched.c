@@ -0,0 +1,86 @@
+/* Prints what unpack_message, pack_message, message_dlc, print_message and
+ * the byte versions of the first two return for every standard identifier,
+ * each identifier given and the one after it, with random payloads, for the
+ * C code generated from the database DATABASE with one way of dispatching
+ * messages. If BUSES is defined the database is a merged one (see dbc_merge)
+ * with that many buses, and each bus is tried.
+ * The output must not depend on the way of dispatching. See "make dispatch". */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING(X) #X
+#define NAME(X) STRING(X)
+#define HEADER(X) STRING(X.h)
+#define OBJECT(X) can_obj_ ## X ## _h_t
+#define OBJECT_TYPE(X) OBJECT(X)
+
+#include HEADER(DATABASE)
+
+#ifdef BUSES
+#define BUS(B) B,
+#else
+#define BUSES (1)
+#define BUS(B)
+#endif
+
+#define STANDARD (0x800ul)
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static unsigned long known = 0;
+
+static void try(OBJECT_TYPE(DATABASE) *o, const unsigned bus, const unsigned long id)
+{
+	(void)bus;
+	const int dlc = message_dlc(BUS(bus) id);
+	const uint64_t data = random_u64();
+	uint64_t packed = 0;
+	const int unpacked = unpack_message(o, BUS(bus) id, data, dlc < 0 || dlc > 8 ? 8 : dlc, 1);
+	const int repacked = pack_message(o, BUS(bus) id, &packed);
+	printf("%u 0x%lx: dlc %d, unpack %d, pack %d 0x%016llx\n", bus, id, dlc, unpacked, repacked, (unsigned long long)packed);
+
+	uint8_t bytes[64] = { 0, }, out[64] = { 0, };
+	const uint8_t length = dlc < 0 ? 8 : dlc;
+	for (size_t i = 0; i < sizeof(bytes); i += 8) {
+		const uint64_t word = random_u64();
+		memcpy(&bytes[i], &word, 8);
+	}
+	const int unpacked_bytes = unpack_message_bytes(o, BUS(bus) id, bytes, length, 2);
+	const int packed_bytes = pack_message_bytes(o, BUS(bus) id, out);
+	printf("%u 0x%lx: unpack bytes %d, pack bytes %d", bus, id, unpacked_bytes, packed_bytes);
+	for (size_t i = 0; i < length; i++)
+		printf("%s%02x", i ? "" : " ", out[i]);
+	printf("\n");
+	if (print_message(o, BUS(bus) id, stdout) >= 0)
+		known++;
+}
+
+int main(int argc, char **argv)
+{
+	static OBJECT_TYPE(DATABASE) o;
+	unsigned long tried = 0;
+	for (unsigned bus = 0; bus < BUSES; bus++) {
+		for (unsigned long id = 0; id < STANDARD; id++, tried++)
+			try(&o, bus, id);
+		for (int i = 1; i < argc; i++) {
+			const unsigned long id = strtoul(argv[i], NULL, 0) & 0x1FFFFFFFul; /* without the extended bit */
+			if (id < STANDARD)
+				continue;
+			try(&o, bus, id);
+			try(&o, bus, (id + 1) & 0x1FFFFFFFul);
+			tried += 2;
+		}
+	}
+	fprintf(stderr, "%s: %lu identifiers tried, %lu known\n", NAME(DATABASE), tried, known);
+	if (!known)
+		printf("(NO MESSAGES)\n");
+	return !known;
+}
@@ -0,0 +1,72 @@
+/* Throughput of decoding one signal from many payloads, with "extract_..."
+ * and with "unpack_message" and "decode_..." a payload at a time, the two
+ * must give the same values. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef PAYLOADS
+#define PAYLOADS (1u << 14) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS     (100)
+#endif
+
+#define SIGNALS(X)\
+	X(0x100, WheelSpeedFL, dbcc_double_t)\
+	X(0x100, WheelSpeedRR, dbcc_double_t)\
+	X(0x200, CoolantTemp,  dbcc_double_t)\
+	X(0x200, Torque,       dbcc_double_t)\
+	X(0x200, Gear,         uint8_t)\
+	X(0x200, Odometer,     dbcc_double_t)
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+#define BENCH(ID, SIGNAL, TYPE) {\
+	static TYPE a[PAYLOADS], b[PAYLOADS];\
+	double each = 1e9, extract = 1e9;\
+	for (int r = 0; r < RUNS; r++) {\
+		const double t0 = now();\
+		for (size_t i = 0; i < PAYLOADS; i++) {\
+			if (unpack_message(&o, ID, data[i], 8, 0) < 0 || decode_can_##ID##_##SIGNAL(&o, &a[i]) < 0)\
+				return 1;\
+		}\
+		const double t1 = now();\
+		extract_can_##ID##_##SIGNAL(data, PAYLOADS, b);\
+		const double t2 = now();\
+		each = t1 - t0 < each ? t1 - t0 : each;\
+		extract = t2 - t1 < extract ? t2 - t1 : extract;\
+	}\
+	const int same = !memcmp(a, b, sizeof(a));\
+	printf("%-14s %8.1f %8.1f %6.1fx %s\n", #SIGNAL, PAYLOADS / each / 1e6, PAYLOADS / extract / 1e6, each / extract, same ? "" : "(DIFFERENT)");\
+	bad += !same;\
+}
+
+int main(void)
+{
+	static can_obj_bench_h_t o;
+	static uint64_t data[PAYLOADS];
+	int bad = 0;
+	for (size_t i = 0; i < PAYLOADS; i++)
+		data[i] = random_u64();
+	printf("%-14s %8s %8s (million values per second)\n", "signal", "each", "extract");
+	SIGNALS(BENCH)
+	return bad != 0;
+}
@@ -0,0 +1,107 @@
+/* Throughput of unpacking and packing the messages in bench/fd.dbc, a classic
+ * one through "unpack_message" and "pack_message" with a 64-bit word and
+ * through "unpack_message_bytes" and "pack_message_bytes" with a byte buffer,
+ * and two CAN-FD ones with a byte buffer. The two ways of handling the
+ * classic message must give the same results, and packing an unpacked
+ * CAN-FD message must give back its payload. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "fd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef FRAMES
+#define FRAMES (1u << 12) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS   (100)
+#endif
+
+typedef struct {
+	uint8_t data[64];
+	uint64_t word;
+} frame_t;
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+#define TIME(BEST, BODY) do {\
+	for (int r = 0; r < RUNS; r++) {\
+		const double t0 = now();\
+		for (size_t i = 0; i < FRAMES; i++) {\
+			BODY;\
+		}\
+		const double t = now() - t0;\
+		BEST = t < BEST ? t : BEST;\
+	}\
+} while (0)
+
+static void row(const char *name, double unpack, double pack)
+{
+	printf("%-22s %8.1f %8.1f\n", name, unpack / FRAMES * 1e9, pack / FRAMES * 1e9);
+}
+
+int main(void)
+{
+	static can_obj_fd_h_t o, p;
+	static frame_t frames[FRAMES];
+	static uint8_t out[64];
+	volatile uint64_t sink = 0;
+	int bad = 0;
+	for (size_t i = 0; i < FRAMES; i++) {
+		for (size_t j = 0; j < sizeof(frames[i].data); j++)
+			frames[i].data[j] = random_u64() >> 56;
+		frames[i].word = 0;
+		for (size_t j = 0; j < 8; j++)
+			frames[i].word |= (uint64_t)frames[i].data[j] << (8 * j);
+	}
+
+	for (size_t i = 0; i < FRAMES; i++) {
+		uint64_t word = 0;
+		bad += unpack_message(&o, 0x100, frames[i].word, 8, 0) < 0;
+		bad += unpack_message_bytes(&p, 0x100, frames[i].data, 8, 0) < 0;
+		bad += memcmp(&o.can_0x100_Classic, &p.can_0x100_Classic, sizeof(o.can_0x100_Classic)) != 0;
+		bad += pack_message(&o, 0x100, &word) != 8;
+		bad += pack_message_bytes(&o, 0x100, out) != 8;
+		for (size_t j = 0; j < 8; j++)
+			bad += out[j] != (uint8_t)(word >> (8 * j)) || out[j] != (frames[i].data[j] & 0x7f);
+		bad += unpack_message_bytes(&o, 0x102, frames[i].data, 64, 0) < 0;
+		bad += pack_message_bytes(&o, 0x102, out) != 64;
+		for (size_t j = 0; j < 64; j++)
+			bad += out[j] != (frames[i].data[j] & 0x7f);
+	}
+
+	double u_word = 1e9, u_bytes = 1e9, u_short = 1e9, u_long = 1e9;
+	double p_word = 1e9, p_bytes = 1e9, p_short = 1e9, p_long = 1e9;
+	TIME(u_word,  unpack_message(&o, 0x100, frames[i].word, 8, 0));
+	TIME(u_bytes, unpack_message_bytes(&o, 0x100, frames[i].data, 8, 0));
+	TIME(u_short, unpack_message_bytes(&o, 0x101, frames[i].data, 12, 0));
+	TIME(u_long,  unpack_message_bytes(&o, 0x102, frames[i].data, 64, 0));
+	TIME(p_word,  uint64_t w = 0; o.can_0x100_Classic.S0 = i; pack_message(&o, 0x100, &w); sink += w);
+	TIME(p_bytes, o.can_0x100_Classic.S0 = i; pack_message_bytes(&o, 0x100, out); sink += out[0]);
+	TIME(p_short, o.can_0x101_Short.S0 = i; pack_message_bytes(&o, 0x101, out); sink += out[0]);
+	TIME(p_long,  o.can_0x102_Long.S0 = i; pack_message_bytes(&o, 0x102, out); sink += out[0]);
+
+	printf("%-22s %8s %8s (nanoseconds per frame)\n", "", "unpack", "pack");
+	row("classic, 64-bit word", u_word, p_word);
+	row("classic, bytes", u_bytes, p_bytes);
+	row("CAN-FD 12 bytes", u_short, p_short);
+	row("CAN-FD 64 bytes", u_long, p_long);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
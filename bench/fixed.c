@@ -0,0 +1,69 @@
+/* Every raw value of each signal in bench/units.dbc, decoded with
+ * "decode_fixed_..." in units of 1/UNITS, must be the exact value rounded
+ * halves away from zero, agree with "decode_..." and encode back to the same
+ * raw value with "encode_fixed_...". See "make fixed". */
+#include "units.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef UNITS
+#define UNITS (1000)
+#endif
+
+/* "decode_..." has the scaling and offset to six significant figures, so is
+ * not as close as "decode_fixed_..." can be */
+#define DOUBLE_ERROR (1e-5L)
+
+/* message, signal, first and last raw value, type of the value, scaling and
+ * offset as fractions, and the largest error allowed in units, the scaling of
+ * "Third" is not quite 1/3 */
+#define SIGNALS(X)\
+	X(0x400, Sensors, Temp,    -2048,    2047,     int32_t, 1,    10,   -40,  1, 0)\
+	X(0x400, Sensors, Torque,  0,        65535,    int32_t, 1,    20,   -100, 1, 0)\
+	X(0x400, Sensors, Level,   0,        255,      int32_t, 1,    8,    0,    1, 0)\
+	X(0x400, Sensors, Third,   -32768,   32767,    int32_t, 1,    3,    0,    1, 1)\
+	X(0x400, Sensors, Speed,   0,        4095,     int32_t, 5,    2,    1000, 1, 0)\
+	X(0x401, Power,   Slope,   -32768,   32767,    int32_t, -1,   2,    10,   1, 0)\
+	X(0x401, Power,   Current, -8388608, 8388607,  int32_t, 1,    1000, -11,  2, 0)\
+	X(0x401, Power,   Energy,  0,        16777215, int64_t, 1000, 1,    0,    1, 0)
+
+typedef long double real_t;
+
+static int64_t rounded(real_t n)
+{
+	return n >= 0 ? (int64_t)floorl(n + 0.5L) : -(int64_t)floorl(0.5L - n);
+}
+
+#define CHECK(ID, MSG, SIGNAL, LO, HI, TYPE, S0, S1, O0, O1, ERROR) {\
+	long bad = 0, trip = 0;\
+	for (int64_t raw = (LO); raw <= (HI); raw++) {\
+		static can_obj_units_h_t o, p;\
+		o.can_##ID##_##MSG.SIGNAL = raw;\
+		TYPE v = 0;\
+		dbcc_double_t d = 0;\
+		const int r = decode_fixed_can_##ID##_##SIGNAL(&o, &v);\
+		if (r != decode_can_##ID##_##SIGNAL(&o, &d)) {\
+			bad++;\
+			continue;\
+		}\
+		if (r < 0) {\
+			bad += v != 0;\
+			continue;\
+		}\
+		const int64_t exact = rounded(((real_t)raw * (S0) * (O1) + (real_t)(O0) * (S1)) * UNITS / ((real_t)(S1) * (O1)));\
+		bad += llabs((long long)(v - exact)) > (ERROR);\
+		bad += fabsl((real_t)v - (real_t)d * UNITS) > 0.5L + (ERROR) + fabsl((real_t)d * UNITS) * DOUBLE_ERROR;\
+		trip += encode_fixed_can_##ID##_##SIGNAL(&p, v) < 0 || p.can_##ID##_##MSG.SIGNAL != raw;\
+	}\
+	printf("%-8s %9ld values, %ld wrong, %ld not encoded back\n", #SIGNAL, (long)((HI) - (LO) + 1), bad, trip);\
+	failed = failed || bad || trip;\
+}
+
+int main(void)
+{
+	int failed = 0;
+	printf("units of 1/%ld\n", (long)UNITS);
+	SIGNALS(CHECK)
+	return failed;
+}
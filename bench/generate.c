@@ -0,0 +1,74 @@
+/* Writes a DBC file with "messages" messages of eight bytes to the standard
+ * output, each with "signals" signals of equal length that fill it. The
+ * identifiers are spread over the 11-bit range, or over the 29-bit range of
+ * extended identifiers with "-x", and are all different. With "-f" every
+ * signal is a 32-bit float with a SIG_VALTYPE_ record. With "-r" every message
+ * and signal has a comment, every signal a value table, and the first signal
+ * of each message is a multiplexor with an SG_MUL_VAL_ record for each of the
+ * others. The same arguments always give the same file. See "make bench" and
+ * "make scaling". */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *usage = "usage: generate [-x] [-f | -r] messages signals\n";
+
+int main(int argc, char **argv)
+{
+	int extended = 0, floats = 0, records = 0, i = 1;
+	for (; i < argc && argv[i][0] == '-'; i++) {
+		if (!strcmp(argv[i], "-x")) {
+			extended = 1;
+		} else if (!strcmp(argv[i], "-f")) {
+			floats = 1;
+		} else if (!strcmp(argv[i], "-r")) {
+			records = 1;
+		} else {
+			fputs(usage, stderr);
+			return 1;
+		}
+	}
+	if (argc - i != 2 || (floats && records)) {
+		fputs(usage, stderr);
+		return 1;
+	}
+	const unsigned long messages = strtoul(argv[i], NULL, 0), signals = strtoul(argv[i + 1], NULL, 0);
+	const unsigned long ids = extended ? 1ul << 29 : 1ul << 11;
+	const unsigned long most = floats ? 2 : records ? 16 : 64; /* the multiplexor must hold "signals" */
+	if (messages > ids || signals < 1 || signals > most) {
+		fprintf(stderr, "at most %lu messages and between 1 and %lu signals\n", ids, most);
+		return 1;
+	}
+	const unsigned length = floats ? 32 : 64 / signals;
+	/* an odd multiplier is a permutation of the identifiers */
+	const unsigned long multiplier = extended ? 0x9E3779B1ul : 0x4D5ul, flag = extended ? 0x80000000ul : 0;
+
+	printf("VERSION \"\"\n\n\nNS_ : \n\tNS_DESC_\n\tCM_\n\tBA_DEF_\n\tBA_\n\tVAL_\n\tSIG_VALTYPE_\n\n");
+	printf("BS_:\n\nBU_: ECU\n\n");
+	for (unsigned long m = 0; m < messages; m++) {
+		printf("\nBO_ %lu M%lu: 8 ECU\n", ((m * multiplier) & (ids - 1)) | flag, m);
+		for (unsigned long s = 0; s < signals; s++) {
+			char mux[8] = "";
+			if (records)
+				snprintf(mux, sizeof(mux), s ? "m%lu " : "M ", s);
+			printf(" SG_ S%lu %s: %lu|%u@1%c (1,0) [0|0] \"\" Vector__XXX\n", s, mux, s * length, length, floats ? '-' : '+');
+		}
+	}
+	fputs(floats || records ? "\n\n" : "", stdout);
+	for (unsigned long m = 0; floats && m < messages; m++)
+		for (unsigned long s = 0; s < signals; s++)
+			printf("SIG_VALTYPE_ %lu S%lu : 1;\n", ((m * multiplier) & (ids - 1)) | flag, s);
+	for (unsigned long m = 0; records && m < messages; m++) {
+		const unsigned long id = ((m * multiplier) & (ids - 1)) | flag;
+		printf("CM_ BO_ %lu \"Message %lu\";\n", id, m);
+		for (unsigned long s = 0; s < signals; s++)
+			printf("CM_ SG_ %lu S%lu \"Signal %lu of message %lu\";\n", id, s, s, m);
+	}
+	for (unsigned long m = 0; records && m < messages; m++)
+		for (unsigned long s = 0; s < signals; s++)
+			printf("VAL_ %lu S%lu 0 \"Off\" 1 \"On\" 2 \"Error\" ;\n", ((m * multiplier) & (ids - 1)) | flag, s);
+	for (unsigned long m = 0; records && m < messages; m++)
+		for (unsigned long s = 1; s < signals; s++)
+			printf("SG_MUL_VAL_ %lu S%lu S0 %lu-%lu;\n", ((m * multiplier) & (ids - 1)) | flag, s, s, s);
+	return 0;
+}
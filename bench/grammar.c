@@ -0,0 +1,82 @@
+/* Time taken to parse each DBC file given with the strict parser, once with
+ * "parse_dbc_file_by_name", which compiles the grammar for every file, and
+ * once with a parse context made before the first, which compiles it once,
+ * and once with another that memoizes the rules that failed. All must give
+ * the same syntax tree. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef RUNS
+#define RUNS (20)
+#endif
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long bad = 0;
+	double t_new = 1e9, t_each = 0, t_context = 0, t_memo = 0;
+	for (int r = 0; r < RUNS; r++) { /* the cost of compiling the grammar alone */
+		const double t0 = now();
+		parse_context_t *ctx = parse_context_new();
+		const double t = now() - t0;
+		parse_context_delete(ctx);
+		t_new = t < t_new ? t : t_new;
+	}
+	parse_context_t *ctx = parse_context_new(), *memo = parse_context_new();
+	if (!ctx || !memo) {
+		fprintf(stderr, "could not compile the grammar\n");
+		return 1;
+	}
+	parse_context_memoize(memo, true);
+	printf("%-28s %10s %10s %10s (microseconds per file)\n", "file", "each", "context", "memoize");
+	for (int i = 1; i < argc; i++) {
+		double each = 1e9, context = 1e9, memoized = 1e9;
+		for (int r = 0; r < RUNS; r++) {
+			const double t0 = now();
+			mpc_ast_t *a = parse_dbc_file_by_name(argv[i]);
+			const double t1 = now();
+			mpc_ast_t *b = parse_context_dbc_file_by_name(ctx, argv[i]);
+			const double t2 = now();
+			mpc_ast_t *c = parse_context_dbc_file_by_name(memo, argv[i]);
+			const double t3 = now();
+			each = t1 - t0 < each ? t1 - t0 : each;
+			context = t2 - t1 < context ? t2 - t1 : context;
+			memoized = t3 - t2 < memoized ? t3 - t2 : memoized;
+			if (r == 0 && (!a != !b || (a && !mpc_ast_eq(a, b)))) {
+				fprintf(stderr, "%s parses differently with a parse context\n", argv[i]);
+				bad++;
+			}
+			if (r == 0 && (!a != !c || (a && !mpc_ast_eq(a, c)))) {
+				fprintf(stderr, "%s parses differently when memoized\n", argv[i]);
+				bad++;
+			}
+			if (a)
+				mpc_ast_delete(a);
+			if (b)
+				mpc_ast_delete(b);
+			if (c)
+				mpc_ast_delete(c);
+		}
+		t_each += each;
+		t_context += context;
+		t_memo += memoized;
+		printf("%-28s %10.1f %10.1f %10.1f\n", argv[i], each * 1e6, context * 1e6, memoized * 1e6);
+	}
+	parse_context_delete(ctx);
+	parse_context_delete(memo);
+	const int files = argc > 1 ? argc - 1 : 1;
+	printf("%-28s %10.1f %10.1f %10.1f\n", "mean", t_each / files * 1e6, t_context / files * 1e6, t_memo / files * 1e6);
+	printf("%-28s %10.1f\n", "compiling the grammar", t_new * 1e6);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
@@ -0,0 +1,127 @@
+/* Every 32-bit pattern (or every STRIDE-th one) of the float signals of the
+ * standard and extended messages in bench/ieee754.dbc, and DOUBLES random
+ * patterns of the double ones, half of them denormal or nearly so, unpacked
+ * with "unpack_message" must be the float or double with the same bits and
+ * pack back to the same pattern, NaNs need only stay NaNs. Then the time taken to unpack and pack each is shown.
+ * Compile with DBCC_IEEE754 defined as 0 to check and time the portable
+ * functions instead of memcpy. See "make ieee754" and "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "ieee754.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef STRIDE
+#define STRIDE  (1)
+#endif
+#ifndef DOUBLES
+#define DOUBLES (1ul << 24)
+#endif
+#ifndef FRAMES
+#define FRAMES  (1u << 16) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS    (50)
+#endif
+
+#if defined(DBCC_IEEE754) && !DBCC_IEEE754
+#define FUNCTIONS "portable"
+#else
+#define FUNCTIONS "memcpy"
+#endif
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+#define TIME(BEST, BODY) do {\
+	for (int r = 0; r < RUNS; r++) {\
+		const double t0 = now();\
+		for (size_t i = 0; i < FRAMES; i++) {\
+			BODY;\
+		}\
+		const double t = now() - t0;\
+		BEST = t < BEST ? t : BEST;\
+	}\
+} while (0)
+
+/* The value of each signal, converted to a float or double if the generator
+ * gave it another type */
+static float single_standard(const can_obj_ieee754_h_t *o) { return o->can_0x100_Single.Value; }
+static float single_extended(const can_obj_ieee754_h_t *o) { return o->can_0x102_ExtendedSingle.Value; }
+static double double_standard(const can_obj_ieee754_h_t *o) { return o->can_0x101_Double.Value; }
+static double double_extended(const can_obj_ieee754_h_t *o) { return o->can_0x103_ExtendedDouble.Value; }
+
+static unsigned long single(can_obj_ieee754_h_t *o, unsigned long id, float (*value)(const can_obj_ieee754_h_t *), uint32_t bits)
+{
+	float expect = 0;
+	uint64_t word = 0;
+	memcpy(&expect, &bits, sizeof(expect));
+	if (unpack_message(o, id, bits, 4, 0) < 0 || pack_message(o, id, &word) != 4)
+		return 1;
+	const float f = value(o);
+	if (isnan(expect)) /* all exponent bits set and some mantissa bits */
+		return !isnan(f) || (word & 0x7f800000u) != 0x7f800000u || !(word & 0x7fffffu) || (word >> 32);
+	return memcmp(&f, &expect, sizeof(f)) != 0 || word != bits;
+}
+
+static unsigned long twice(can_obj_ieee754_h_t *o, unsigned long id, double (*value)(const can_obj_ieee754_h_t *), uint64_t bits)
+{
+	double expect = 0;
+	uint64_t word = 0;
+	memcpy(&expect, &bits, sizeof(expect));
+	if (unpack_message(o, id, bits, 8, 0) < 0 || pack_message(o, id, &word) != 8)
+		return 1;
+	const double d = value(o);
+	const uint64_t exponent = 0x7ffull << 52;
+	if (isnan(expect))
+		return !isnan(d) || (word & exponent) != exponent || !(word & ~(exponent | 1ull << 63));
+	return memcmp(&d, &expect, sizeof(d)) != 0 || word != bits;
+}
+
+int main(void)
+{
+	static can_obj_ieee754_h_t o;
+	static uint64_t frames[FRAMES];
+	volatile double sink = 0;
+	unsigned long floats = 0, bad_floats = 0, bad_doubles = 0;
+
+	for (uint64_t bits = 0; bits < (1ull << 32); bits += STRIDE, floats++)
+		bad_floats += single(&o, 0x100, single_standard, bits) + single(&o, 0x102, single_extended, bits);
+	for (unsigned long i = 0; i < DOUBLES; i++) {
+		uint64_t bits = random_u64();
+		if (i & 1) /* exponent of zero, one or two */
+			bits = (bits & 0x800fffffffffffffull) | ((bits >> 52) % 3) << 52;
+		bad_doubles += twice(&o, 0x101, double_standard, bits) + twice(&o, 0x103, double_extended, bits);
+	}
+	printf("%s: %lu float patterns, %lu wrong, %lu double patterns, %lu wrong\n",
+			FUNCTIONS, floats, bad_floats, (unsigned long)DOUBLES, bad_doubles);
+
+	for (size_t i = 0; i < FRAMES; i++)
+		frames[i] = random_u64();
+	double u_single = 1e9, u_double = 1e9, p_single = 1e9, p_double = 1e9;
+	TIME(u_single, unpack_message(&o, 0x100, frames[i] & 0xffffffffu, 4, 0); sink += o.can_0x100_Single.Value);
+	TIME(u_double, unpack_message(&o, 0x101, frames[i], 8, 0); sink += o.can_0x101_Double.Value);
+	TIME(p_single, uint64_t w = 0; o.can_0x100_Single.Value = i; pack_message(&o, 0x100, &w); sink += w);
+	TIME(p_double, uint64_t w = 0; o.can_0x101_Double.Value = i; pack_message(&o, 0x101, &w); sink += w);
+	printf("%-22s %8s %8s (nanoseconds per frame)\n", FUNCTIONS, "unpack", "pack");
+	printf("%-22s %8.1f %8.1f\n", "float", u_single / FRAMES * 1e9, p_single / FRAMES * 1e9);
+	printf("%-22s %8.1f %8.1f\n", "double", u_double / FRAMES * 1e9, p_double / FRAMES * 1e9);
+	if (bad_floats || bad_doubles)
+		printf("(DIFFERENT)\n");
+	return bad_floats || bad_doubles;
+}
@@ -0,0 +1,106 @@
+/* The layout (see layout.h) of each message in bench/layout.dbc, and the
+ * layout flags of each of its signals, must be the ones worked out by hand
+ * below. The file has aligned signals, the same signals overlapped by
+ * another, a multiplexed message with a signal beyond its DLC and one with
+ * gaps. See "make layout". */
+#include "can.h"
+#include "layout.h"
+#include "read.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WHOLE (LAYOUT_INSIDE | LAYOUT_DISJOINT | LAYOUT_ALIGNED)
+
+static const struct {
+	const char *name;
+	unsigned branches, overlaps, gaps, beyond;
+} messages[] = {
+	{ "Aligned",      1, 0,  0, 0, },
+	{ "Overlapped",   1, 4,  0, 0, },
+	{ "AlignedFd",    1, 0,  0, 0, },
+	{ "OverlappedFd", 1, 5,  0, 0, },
+	{ "Muxed",        3, 0,  0, 8, },
+	{ "Gappy",        1, 0, 56, 0, },
+};
+
+static const struct {
+	const char *message, *signal;
+	unsigned layout;
+} signals[] = {
+	{ "Aligned",      "U8",     WHOLE, },
+	{ "Aligned",      "S16",    WHOLE, },
+	{ "Aligned",      "M32",    WHOLE, },
+	{ "Aligned",      "U8b",    WHOLE, },
+	{ "Overlapped",   "U8",     LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "Overlapped",   "S16",    LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "Overlapped",   "M32",    LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "Overlapped",   "U8b",    LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "Overlapped",   "Cover",  LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "AlignedFd",    "S32",    WHOLE, },
+	{ "OverlappedFd", "S32",    LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "OverlappedFd", "Cover2", LAYOUT_INSIDE | LAYOUT_ALIGNED, },
+	{ "Muxed",        "Sel",    WHOLE, },
+	{ "Muxed",        "A",      WHOLE, }, /* overlaps B in another branch */
+	{ "Muxed",        "B",      WHOLE, },
+	{ "Muxed",        "Far",    LAYOUT_DISJOINT | LAYOUT_ALIGNED, },
+	{ "Gappy",        "Low",    LAYOUT_INSIDE | LAYOUT_DISJOINT, },
+	{ "Gappy",        "High",   LAYOUT_INSIDE | LAYOUT_DISJOINT, },
+};
+
+static const can_msg_t *message(const dbc_t *dbc, const char *name)
+{
+	for (size_t i = 0; i < dbc->message_count; i++)
+		if (!strcmp(dbc->messages[i]->name, name))
+			return dbc->messages[i];
+	return NULL;
+}
+
+static const signal_t *signal(const can_msg_t *c, const char *name)
+{
+	for (size_t i = 0; c && i < c->signal_count; i++)
+		if (!strcmp(c->sigs[i]->name, name))
+			return c->sigs[i];
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s layout.dbc\n", argv[0]);
+		return 1;
+	}
+	const read_options_t options = { .threads = 1, .needs = READ_ALL, };
+	dbc_t *dbc = read_dbc_file_with_options(argv[1], &options);
+	if (!dbc) {
+		fprintf(stderr, "could not read %s\n", argv[1]);
+		return 1;
+	}
+	unsigned long bad = 0, checks = 0;
+	for (size_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++, checks++) {
+		const can_msg_t *c = message(dbc, messages[i].name);
+		const layout_t *l = c ? c->layout : NULL;
+		if (!l || l->branches != messages[i].branches || l->overlaps != messages[i].overlaps
+				|| l->gaps != messages[i].gaps || l->beyond != messages[i].beyond) {
+			fprintf(stderr, "message %s: layout is wrong\n", messages[i].name);
+			bad++;
+		}
+	}
+	for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++, checks++) {
+		const signal_t *s = signal(message(dbc, signals[i].message), signals[i].signal);
+		if (!s || s->layout != signals[i].layout) {
+			fprintf(stderr, "signal %s of %s: layout 0x%x, not 0x%x\n", signals[i].signal,
+					signals[i].message, s ? s->layout : 0u, signals[i].layout);
+			bad++;
+		}
+	}
+	/* every bit of the overlapped messages is shared, and none of the others */
+	const can_msg_t *overlapped = message(dbc, "Overlapped"), *aligned = message(dbc, "Aligned");
+	for (unsigned b = 0; b < 8; b++, checks++)
+		bad += overlapped->layout->overlap[b] != 0xFF || aligned->layout->overlap[b] != 0;
+	printf("%lu layouts checked, %lu wrong\n", checks, bad);
+	dbc_delete(dbc);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
@@ -0,0 +1,86 @@
+/* Merging bench/merge/left.dbc and bench/merge/right.dbc, which both have a
+ * message called "Status", must rename the one on the bus "right" to
+ * "right_Status", and every name, unit and ECU of the merged database must
+ * be interned in its symbol table. Merging bench/merge/duplicate.dbc, which
+ * has two messages with the same identifier, must fail. See "make merge". */
+#include "can.h"
+#include "intern.h"
+#include "read.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static dbc_t *load(const char *name)
+{
+	const read_options_t options = { .threads = 1, .needs = READ_ALL, };
+	dbc_t *dbc = read_dbc_file_with_options(name, &options);
+	if (!dbc) {
+		fprintf(stderr, "could not read %s\n", name);
+		exit(1);
+	}
+	return dbc;
+}
+
+/* A string that is not the copy in the symbol table is counted */
+static unsigned long stray(const dbc_t *d, const char *s)
+{
+	return s && intern_find(d->symbols, s, strlen(s)) != s;
+}
+
+static unsigned long strays(const dbc_t *d)
+{
+	unsigned long n = 0;
+	for (size_t i = 0; i < d->message_count; i++) {
+		const can_msg_t *c = d->messages[i];
+		n += stray(d, c->name) + stray(d, c->ecu);
+		for (size_t j = 0; j < c->signal_count; j++) {
+			const signal_t *sig = c->sigs[j];
+			n += stray(d, sig->name) + stray(d, sig->units);
+			for (size_t k = 0; k < sig->ecu_count; k++)
+				n += stray(d, sig->ecus[k]);
+		}
+	}
+	for (size_t i = 0; i < d->val_count; i++) {
+		n += stray(d, d->vals[i]->name);
+		for (size_t j = 0; j < d->vals[i]->val_list_item_count; j++)
+			n += stray(d, d->vals[i]->val_list_items[j]->name);
+	}
+	for (size_t i = 0; i < d->mul_val_count; i++)
+		n += stray(d, d->mul_vals[i]->multiplexed) + stray(d, d->mul_vals[i]->multiplexor);
+	for (size_t i = 0; i < d->sigval_count; i++)
+		n += stray(d, d->sigvals[i]->name);
+	return n;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s left.dbc right.dbc duplicate.dbc\n", argv[0]);
+		return 1;
+	}
+	unsigned long bad = 0;
+	const char *buses[] = { "left", "right", };
+	dbc_t *parts[] = { load(argv[1]), load(argv[2]), };
+	dbc_t *d = dbc_merge(parts, buses, 2);
+	if (!d) {
+		fprintf(stderr, "could not merge %s and %s\n", argv[1], argv[2]);
+		return 1;
+	}
+	unsigned long renamed = 0;
+	for (size_t i = 0; i < d->message_count; i++)
+		renamed += d->messages[i]->bus == 1 && !strcmp(d->messages[i]->name, "right_Status");
+	const unsigned long strings = strays(d);
+	printf("%zu messages merged, %lu renamed, %lu strings not interned\n", d->message_count, renamed, strings);
+	bad += renamed != 1 || strings;
+	dbc_delete(d);
+
+	dbc_t *duplicate[] = { load(argv[1]), load(argv[3]), };
+	const char *names[] = { "left", "duplicate", };
+	d = dbc_merge(duplicate, names, 2);
+	printf("merging %s %s\n", argv[3], d ? "succeeded" : "failed");
+	bad += d != NULL;
+	dbc_delete(d);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
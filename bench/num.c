@@ -0,0 +1,256 @@
+/* Numbers converted with "num_double", "num_u64" and "num_i64" must be the
+ * same as those given by "strtod", "strtoull" and "strtoll" in the "C"
+ * locale, with numbers too large in magnitude being an error. The doubles are
+ * every STRIDE-th float pattern printed with "%.9g" and "%g", random doubles
+ * printed with 17, 15 and 6 significant figures, and numbers like those in
+ * DBC files. If a locale with a ',' decimal point is installed the doubles
+ * are converted again in it. Then the time taken to convert numbers like
+ * those in DBC files is compared with "sscanf". See "make num". */
+#define _POSIX_C_SOURCE 199309L
+#include "num.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef STRIDE
+#define STRIDE  (97)
+#endif
+#ifndef DOUBLES
+#define DOUBLES (1ul << 20)
+#endif
+#ifndef RUNS
+#define RUNS    (20)
+#endif
+
+/* typical scalings, offsets, ranges, identifiers and values */
+static const char *typical[] = {
+	"0.1", "-40", "0.05", "100", "0.125", "2.5", "1000", "-3276.8", "3276.7",
+	"1E-005", "0.001", "65535", "1", "0", "-0.5", "6.25E-002", "1250", "0.0625",
+	"4294967295", "2566625537", "-2147483648", "12345.678", "1e-10", "3.6",
+};
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+static unsigned long checks = 0;
+
+static unsigned long check_double(const char *s)
+{
+	double d = 0, expect = 0;
+	char *end = NULL;
+	errno = 0;
+	expect = strtod(s, &end);
+	const int fails = end == s || *end || (errno == ERANGE && isinf(expect));
+	const int r = num_double(s, strlen(s), &d);
+	checks++;
+	if (fails ? r == 0 : r < 0 || memcmp(&d, &expect, sizeof(d)) != 0) {
+		fprintf(stderr, "num_double(\"%s\") is %.17g (%d) not %.17g\n", s, d, r, expect);
+		return 1;
+	}
+	return 0;
+}
+
+static unsigned long check_integer(const char *s)
+{
+	uint64_t u = 0;
+	int64_t i = 0;
+	char *end = NULL;
+	errno = 0;
+	const unsigned long long eu = *s == '-' ? 0 : strtoull(s, &end, 10);
+	const int ufails = *s == '-' || end == s || *end || errno == ERANGE;
+	errno = 0;
+	const long long ei = strtoll(s, &end, 10);
+	const int ifails = end == s || *end || errno == ERANGE;
+	const int ru = num_u64(s, strlen(s), &u), ri = num_i64(s, strlen(s), &i);
+	checks += 2;
+	unsigned long bad = 0;
+	bad += ufails ? ru == 0 : ru < 0 || u != eu;
+	bad += ifails ? ri == 0 : ri < 0 || i != ei;
+	if (bad)
+		fprintf(stderr, "num_u64 or num_i64 of \"%s\" is wrong\n", s);
+	return bad;
+}
+
+/* Every double to be checked is passed to "f" */
+static unsigned long doubles(unsigned long (*f)(const char *))
+{
+	static const char *edges[] = {
+		"0", "-0", "+0.0", "1e308", "1.7976931348623157e308", "1.7976931348623159e308",
+		"-1e309", "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+		"1e-400", "9007199254740993", "9007199254740992.5", "123456789012345678901234567890",
+		"0.30000000000000004", "1e22", "1e23", ".5", "5.", "1.e5", "e5", ".", "", "-", "1e", "1e+",
+		"1,5", "1 ", "12345678901234567890e-20",
+	};
+	char s[64];
+	unsigned long bad = 0;
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+		bad += f(edges[i]);
+	for (size_t i = 0; i < sizeof(typical) / sizeof(typical[0]); i++)
+		bad += f(typical[i]);
+	for (uint64_t bits = 0; bits < (1ull << 32); bits += STRIDE) {
+		const uint32_t b = bits;
+		float x = 0;
+		memcpy(&x, &b, sizeof(x));
+		if (!isfinite(x))
+			continue;
+		snprintf(s, sizeof(s), "%.9g", x);
+		bad += f(s);
+		snprintf(s, sizeof(s), "%g", x);
+		bad += f(s);
+	}
+	for (unsigned long i = 0; i < DOUBLES; i++) {
+		const uint64_t b = random_u64();
+		double x = 0;
+		memcpy(&x, &b, sizeof(x));
+		if (!isfinite(x))
+			continue;
+		static const int figures[] = { 17, 15, 6, };
+		snprintf(s, sizeof(s), "%.*g", figures[i % 3], x);
+		bad += f(s);
+	}
+	for (long i = -1000000; i <= 1000000; i += 7) { /* fixed point, like "0.125" */
+		snprintf(s, sizeof(s), "%s%ld.%03ld", i < 0 ? "-" : "", labs(i) / 1000, labs(i) % 1000);
+		bad += f(s);
+	}
+	return bad;
+}
+
+static unsigned long integers(void)
+{
+	static const char *edges[] = {
+		"0", "+0", "-0", "18446744073709551615", "18446744073709551616",
+		"9223372036854775807", "9223372036854775808", "-9223372036854775808",
+		"-9223372036854775809", "99999999999999999999999", "", "+", "-", "1.0",
+		"1e3", "1 ", "0x10",
+	};
+	char s[64];
+	unsigned long bad = 0;
+	for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+		bad += check_integer(edges[i]);
+	for (unsigned long i = 0; i < DOUBLES; i++) {
+		const uint64_t r = random_u64() >> (random_u64() % 64);
+		snprintf(s, sizeof(s), i & 1 ? "-%"PRIu64 : "%"PRIu64, r);
+		bad += check_integer(s);
+	}
+	return bad;
+}
+
+/* The result of converting each double in the "C" locale, which "again"
+ * then compares with the result in another locale */
+static double *results = NULL;
+static size_t nresults = 0, allocated = 0, used = 0;
+
+static unsigned long record(const char *s)
+{
+	double d = 0;
+	if (num_double(s, strlen(s), &d) < 0)
+		d = -HUGE_VAL; /* not a number with a '.' */
+	if (nresults == allocated) {
+		allocated = allocated ? allocated * 2 : 1024;
+		if (!(results = realloc(results, allocated * sizeof(*results)))) {
+			fprintf(stderr, "out of memory\n");
+			exit(1);
+		}
+	}
+	results[nresults++] = d;
+	return 0;
+}
+
+static unsigned long again(const char *s)
+{
+	double d = 0;
+	if (num_double(s, strlen(s), &d) < 0)
+		d = -HUGE_VAL;
+	checks++;
+	return memcmp(&d, &results[used++], sizeof(d)) != 0;
+}
+
+static unsigned long locales(void)
+{
+	static const char *names[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR", "nl_NL.UTF-8", };
+	const char *found = NULL;
+	for (size_t i = 0; !found && i < sizeof(names) / sizeof(names[0]); i++)
+		if (setlocale(LC_NUMERIC, names[i]) && !strcmp(localeconv()->decimal_point, ","))
+			found = names[i];
+	setlocale(LC_NUMERIC, "C");
+	if (!found) {
+		printf("no locale with a ',' decimal point is installed\n");
+		return 0;
+	}
+	doubles(record);
+	setlocale(LC_NUMERIC, found);
+	const unsigned long bad = doubles(again);
+	setlocale(LC_NUMERIC, "C");
+	printf("converted again in the %s locale\n", found);
+	free(results);
+	return bad;
+}
+
+int main(void)
+{
+	const size_t n = sizeof(typical) / sizeof(typical[0]);
+	unsigned long bad = doubles(check_double) + integers() + locales();
+	printf("%lu numbers checked, %lu wrong\n", checks, bad);
+
+	volatile double sink = 0;
+	double t_num = 1e9, t_scanf = 1e9, t_u64 = 1e9, t_scanu = 1e9;
+	for (int r = 0; r < RUNS; r++) {
+		double t0 = now();
+		for (int k = 0; k < 1000; k++)
+			for (size_t i = 0; i < n; i++) {
+				double d = 0;
+				num_double(typical[i], strlen(typical[i]), &d);
+				sink += d;
+			}
+		double t1 = now();
+		for (int k = 0; k < 1000; k++)
+			for (size_t i = 0; i < n; i++) {
+				double d = 0;
+				sscanf(typical[i], "%lf", &d);
+				sink += d;
+			}
+		double t2 = now();
+		for (int k = 0; k < 1000; k++)
+			for (size_t i = 0; i < n; i++) {
+				uint64_t u = 0;
+				num_u64("2566625537", 10, &u);
+				sink += u;
+			}
+		double t3 = now();
+		for (int k = 0; k < 1000; k++)
+			for (size_t i = 0; i < n; i++) {
+				unsigned long u = 0;
+				sscanf("2566625537", "%lu", &u);
+				sink += u;
+			}
+		double t4 = now();
+		t_num = t1 - t0 < t_num ? t1 - t0 : t_num;
+		t_scanf = t2 - t1 < t_scanf ? t2 - t1 : t_scanf;
+		t_u64 = t3 - t2 < t_u64 ? t3 - t2 : t_u64;
+		t_scanu = t4 - t3 < t_scanu ? t4 - t3 : t_scanu;
+	}
+	printf("%-10s %8s %8s (nanoseconds per number)\n", "", "num", "sscanf");
+	printf("%-10s %8.1f %8.1f\n", "double", t_num / (n * 1000) * 1e9, t_scanf / (n * 1000) * 1e9);
+	printf("%-10s %8.1f %8.1f\n", "unsigned", t_u64 / (n * 1000) * 1e9, t_scanu / (n * 1000) * 1e9);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
@@ -0,0 +1,139 @@
+/* Throughput of unpacking frames into the physical value of each signal,
+ * checked against its range and its multiplexor, with "unpack_physical_..."
+ * and with "unpack_message" and "decode_..." for each signal, the two must
+ * give the same values. See "make bench". */
+#define _POSIX_C_SOURCE 199309L
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef FRAMES
+#define FRAMES (1u << 14) /* small enough to stay in the cache */
+#endif
+#ifndef RUNS
+#define RUNS   (100)
+#endif
+
+#define MESSAGES(X)\
+	X(0x100, WheelSpeeds, WHEELS)\
+	X(0x200, Engine,      ENGINE)\
+	X(0x300, Battery,     BATTERY)
+
+#define WHEELS(X, ID, MSG)\
+	X(ID, MSG, WheelSpeedFL, dbcc_double_t, 1)\
+	X(ID, MSG, WheelSpeedFR, dbcc_double_t, 1)\
+	X(ID, MSG, WheelSpeedRL, dbcc_double_t, 1)\
+	X(ID, MSG, WheelSpeedRR, dbcc_double_t, 1)
+
+#define ENGINE(X, ID, MSG)\
+	X(ID, MSG, CoolantTemp, dbcc_double_t, 1)\
+	X(ID, MSG, Torque,      dbcc_double_t, 1)\
+	X(ID, MSG, Gear,        uint8_t,       1)\
+	X(ID, MSG, OilPressure, dbcc_double_t, 1)\
+	X(ID, MSG, Odometer,    dbcc_double_t, 1)
+
+#define BATTERY(X, ID, MSG)\
+	X(ID, MSG, Mode,        uint8_t,       1)\
+	X(ID, MSG, CellVoltage, dbcc_double_t, o.can_0x300_Battery.Mode == 0)\
+	X(ID, MSG, CellTemp,    int8_t,        o.can_0x300_Battery.Mode == 1)\
+	X(ID, MSG, Current,     dbcc_double_t, 1)\
+	X(ID, MSG, Charge,      dbcc_double_t, 1)\
+	X(ID, MSG, Voltage,     dbcc_double_t, 1)
+
+#define DECODE(ID, MSG, SIGNAL, TYPE, SELECTED) {\
+	TYPE v = 0;\
+	const int ok = decode_can_##ID##_##SIGNAL(&o, &v) == 0 && (SELECTED);\
+	p->SIGNAL = ok ? v : 0;\
+	p->valid |= ok ? PHYSICAL_VALID_can_##ID##_##MSG##_##SIGNAL : 0;\
+}
+
+#define COMPARE(ID, MSG, SIGNAL, TYPE, SELECTED) same = same && a->SIGNAL == b->SIGNAL;
+
+#define EACH(ID, MSG, SIGNALS) case ID: {\
+	can_##ID##_##MSG##_physical_t *p = &each.MSG[i];\
+	bad += unpack_message(&o, ID, frames[i].data, 8, 0) < 0 && ID != 0x300;\
+	p->valid = 0;\
+	SIGNALS(DECODE, ID, MSG)\
+	break;\
+}
+
+#define FUSED(ID, MSG, SIGNALS) case ID: bad += unpack_physical_can_##ID##_##MSG(&fused.MSG[i], frames[i].data, 8) < 0; break;
+
+#define CHECK(ID, MSG, SIGNALS) case ID: {\
+	const can_##ID##_##MSG##_physical_t *a = &each.MSG[i], *b = &fused.MSG[i];\
+	same = same && a->valid == b->valid;\
+	SIGNALS(COMPARE, ID, MSG)\
+	valid += a->valid != 0;\
+	break;\
+}
+
+#define PHYSICAL(ID, MSG, SIGNALS) can_##ID##_##MSG##_physical_t MSG[FRAMES];
+
+typedef struct {
+	uint64_t data;
+	unsigned long id;
+} frame_t;
+
+typedef struct {
+	MESSAGES(PHYSICAL)
+} physical_t;
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(void)
+{
+	static can_obj_bench_h_t o;
+	static frame_t frames[FRAMES];
+	static physical_t each, fused;
+	int bad = 0, same = 1;
+	double t_each = 1e9, t_fused = 1e9;
+	for (size_t i = 0; i < FRAMES; i++) {
+		static const unsigned long ids[] = { 0x100, 0x200, 0x300, };
+		frames[i].id = ids[random_u64() % 3];
+		frames[i].data = random_u64();
+		if (frames[i].id == 0x300) /* mostly a mode that is known */
+			frames[i].data = (frames[i].data & ~(uint64_t)0xff) | (random_u64() % 3);
+	}
+	for (int r = 0; r < RUNS; r++) {
+		const double t0 = now();
+		for (size_t i = 0; i < FRAMES; i++) {
+			switch (frames[i].id) {
+			MESSAGES(EACH)
+			}
+		}
+		const double t1 = now();
+		for (size_t i = 0; i < FRAMES; i++) {
+			switch (frames[i].id) {
+			MESSAGES(FUSED)
+			}
+		}
+		const double t2 = now();
+		t_each = t1 - t0 < t_each ? t1 - t0 : t_each;
+		t_fused = t2 - t1 < t_fused ? t2 - t1 : t_fused;
+	}
+	size_t valid = 0;
+	for (size_t i = 0; i < FRAMES; i++) {
+		switch (frames[i].id) {
+		MESSAGES(CHECK)
+		}
+	}
+	printf("%-14s %8s %8s (million frames per second)\n", "", "each", "physical");
+	printf("%-14s %8.1f %8.1f %6.1fx %s\n", "frames", FRAMES / t_each / 1e6, FRAMES / t_fused / 1e6, t_each / t_fused, same ? "" : "(DIFFERENT)");
+	return bad || !same || !valid;
+}
@@ -0,0 +1,87 @@
+/* Time taken to read each DBC file given, resolve its records and generate C
+ * code for it, per signal, which reads the comments of the messages and
+ * signals. The files are made by bench/generate.c and given
+ * from the smallest to the largest, the time per signal of the largest must
+ * be no more than LIMIT times that of the smallest, work that grows with the
+ * square of the number of signals would be eight times as much for eight
+ * times the signals. With "-r" the files were made with "generate -r" and
+ * every message and signal must have a comment, and every signal a value
+ * table. See "make scaling". */
+#define _POSIX_C_SOURCE 199309L
+#include "2c.h"
+#include "read.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef RUNS
+#define RUNS  (3)
+#endif
+#ifndef LIMIT
+#define LIMIT (4.0)
+#endif
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + (t.tv_nsec * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+	double first = 0, last = 0;
+	unsigned long missing = 0;
+	const int records = argc > 1 && !strcmp(argv[1], "-r");
+	FILE *null = fopen("/dev/null", "wb");
+	if (!null) {
+		fprintf(stderr, "could not open /dev/null\n");
+		return 1;
+	}
+	printf("%-28s %8s %8s %8s %8s %10s\n", "file", "signals", "floats", "values", "comments", "ns/signal");
+	for (int i = 1 + records; i < argc; i++) {
+		double best = 1e9;
+		unsigned long signals = 0, floats = 0, values = 0, comments = 0;
+		for (int r = 0; r < RUNS; r++) {
+			dbc2c_options_t copts = {
+				.use_id_in_name = true, .generate_print = true, .generate_pack = true,
+				.generate_unpack = true, .generate_asserts = true, .version = 3,
+			};
+			const read_options_t options = { .threads = 1, .needs = READ_ALL, };
+			const double t0 = now();
+			dbc_t *dbc = read_dbc_file_with_options(argv[i], &options);
+			if (!dbc || dbc2c(dbc, null, null, "scaling.h", &copts) < 0) {
+				fprintf(stderr, "could not convert %s\n", argv[i]);
+				return 1;
+			}
+			const double t = now() - t0;
+			best = t < best ? t : best;
+			signals = floats = values = comments = 0;
+			for (size_t j = 0; j < dbc->message_count; j++) {
+				missing += records && r == 0 && !dbc->messages[j]->comment;
+				for (size_t k = 0; k < dbc->messages[j]->signal_count; k++, signals++) {
+					const signal_t *sig = dbc->messages[j]->sigs[k];
+					floats += sig->is_floating;
+					values += sig->val_list != NULL;
+					comments += sig->comment != NULL;
+				}
+			}
+			missing += records && r == 0 ? 2 * signals - values - comments : 0;
+			dbc_delete(dbc);
+		}
+		last = best / (signals ? signals : 1) * 1e9;
+		first = i == 1 + records ? last : first;
+		printf("%-28s %8lu %8lu %8lu %8lu %10.1f\n", argv[i], signals, floats, values, comments, last);
+	}
+	fclose(null);
+	if (missing) {
+		printf("(%lu COMMENTS OR VALUE TABLES MISSING)\n", missing);
+		return 1;
+	}
+	if (last > first * LIMIT) {
+		printf("(NOT LINEAR)\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,71 @@
+/* The signals of the messages "Aligned" and "AlignedFd" in bench/layout.dbc
+ * are unpacked and packed without masks (see "unmasked" in 2c.c), those of
+ * "Overlapped" and "OverlappedFd" are the same signals with another one over
+ * them, so they take the masked paths. Both must give the same signals for
+ * random payloads, and the same payload back when packed. See "make layout". */
+#include "layout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef RUNS
+#define RUNS (100000)
+#endif
+
+static uint64_t random_u64(void)
+{
+	static uint64_t s = 88172645463325252ull;
+	s ^= s << 13;
+	s ^= s >> 7;
+	s ^= s << 17;
+	return s;
+}
+
+static int same(const can_obj_layout_h_t *o)
+{
+	const can_0x100_Aligned_t *a = &o->can_0x100_Aligned;
+	const can_0x101_Overlapped_t *b = &o->can_0x101_Overlapped;
+	return a->U8 == b->U8 && a->S16 == b->S16 && a->M32 == b->M32 && a->U8b == b->U8b;
+}
+
+static int same_fd(const can_obj_layout_h_t *o)
+{
+	const can_0x102_AlignedFd_t *a = &o->can_0x102_AlignedFd;
+	const can_0x103_OverlappedFd_t *b = &o->can_0x103_OverlappedFd;
+	return a->U8 == b->U8 && a->S16 == b->S16 && a->M32 == b->M32 && a->U8b == b->U8b && a->S32 == b->S32;
+}
+
+int main(void)
+{
+	static can_obj_layout_h_t o;
+	unsigned long bad = 0;
+	for (long r = 0; r < RUNS; r++) {
+		const uint64_t data = random_u64();
+		uint64_t aligned = 0, overlapped = 0;
+		if (unpack_message(&o, 0x100, data, 8, 0) < 0 || unpack_message(&o, 0x101, data, 8, 0) < 0)
+			bad++;
+		bad += !same(&o);
+		o.can_0x101_Overlapped.Cover = 0;
+		if (pack_message(&o, 0x100, &aligned) < 0 || pack_message(&o, 0x101, &overlapped) < 0)
+			bad++;
+		bad += aligned != data || overlapped != data;
+
+		uint8_t bytes[64] = { 0, }, packed[64] = { 0, }, repacked[64] = { 0, };
+		for (size_t i = 0; i < 12; i += 4) {
+			const uint64_t word = random_u64();
+			memcpy(&bytes[i], &word, 4);
+		}
+		if (unpack_message_bytes(&o, 0x102, bytes, 12, 0) < 0 || unpack_message_bytes(&o, 0x103, bytes, 12, 0) < 0)
+			bad++;
+		bad += !same_fd(&o);
+		o.can_0x103_OverlappedFd.Cover = 0;
+		o.can_0x103_OverlappedFd.Cover2 = 0;
+		if (pack_message_bytes(&o, 0x102, packed) < 0 || pack_message_bytes(&o, 0x103, repacked) < 0)
+			bad++;
+		bad += memcmp(packed, bytes, 12) || memcmp(repacked, bytes, 12);
+	}
+	printf("%ld payloads unpacked and packed, %lu differences\n", (long)RUNS, bad);
+	if (bad)
+		printf("(DIFFERENT)\n");
+	return bad != 0;
+}
@@ -0,0 +1,93 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief Generated output cache, see cache.h. */
+#include "cache.h"
+#include "util.h"
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CACHE_MAGIC "dbcc-cache 1"
+
+/* Files are hashed in blocks, chaining the hash of each block into the
+ * next, so large outputs are not held in memory */
+int cache_hash_file(const char *name, uint64_t seed, uint64_t *hash)
+{
+	assert(name);
+	assert(hash);
+	FILE *f = fopen(name, "rb");
+	if (!f)
+		return -1;
+	static char block[64 * 1024];
+	uint64_t h = seed;
+	for (size_t n = 0; (n = fread(block, 1, sizeof(block), f));)
+		h = hash64(block, n, h);
+	const int r = ferror(f) ? -1 : 0;
+	fclose(f);
+	*hash = h;
+	return r;
+}
+
+static char *entry_name(const char *dir, uint64_t key)
+{
+	assert(dir);
+	const size_t length = strlen(dir) + 32;
+	char *name = allocate(length);
+	snprintf(name, length, "%s/%016"PRIx64".cache", dir, key);
+	return name;
+}
+
+bool cache_hit(const char *dir, uint64_t key)
+{
+	assert(dir);
+	char *name = entry_name(dir, key);
+	FILE *f = fopen(name, "rb");
+	free(name);
+	if (!f)
+		return false;
+	bool hit = false;
+	char line[4096];
+	if (!fgets(line, sizeof(line), f) || strcmp(line, CACHE_MAGIC "\n"))
+		goto done;
+	for (size_t outputs = 0;; outputs++) {
+		if (!fgets(line, sizeof(line), f)) {
+			hit = outputs > 0 && !ferror(f);
+			break;
+		}
+		char *end = NULL;
+		const uint64_t expected = strtoull(line, &end, 16);
+		if (end == line || *end++ != ' ')
+			break;
+		end[strcspn(end, "\n")] = '\0';
+		uint64_t actual = 0;
+		if (cache_hash_file(end, 0, &actual) < 0 || actual != expected)
+			break;
+	}
+done:
+	fclose(f);
+	return hit;
+}
+
+int cache_store(const char *dir, uint64_t key, char **outputs, size_t count)
+{
+	assert(dir);
+	assert(outputs);
+	char *name = entry_name(dir, key);
+	FILE *f = fopen_output(name);
+	int r = fprintf(f, CACHE_MAGIC "\n") < 0 ? -1 : 0;
+	for (size_t i = 0; r == 0 && i < count; i++) {
+		uint64_t hash = 0;
+		if (strchr(outputs[i], '\n') || cache_hash_file(outputs[i], 0, &hash) < 0)
+			r = -1;
+		else if (fprintf(f, "%016"PRIx64" %s\n", hash, outputs[i]) < 0)
+			r = -1;
+	}
+	if (fclose_output(f, name) < 0)
+		r = -1;
+	if (r < 0)
+		(void)remove(name);
+	free(name);
+	return r;
+}
@@ -0,0 +1,35 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT */
+#ifndef CACHE_H
+#define CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A cache of which outputs were generated from what, so that regenerating
+ * outputs that are already up to date can be skipped without parsing the
+ * input. An entry is a file in the cache directory named after a key, the
+ * key must be a hash of the input file and of every setting that affects
+ * the output (including the names of the outputs), the entry lists each
+ * output with a hash of its contents. */
+
+/* Hash the contents of a file, returns -1 if it cannot be read */
+int cache_hash_file(const char *name, uint64_t seed, uint64_t *hash);
+
+/* True if there is an entry for "key" and all of its outputs still exist
+ * with the contents they were generated with. */
+bool cache_hit(const char *dir, uint64_t key);
+
+/* Record the outputs, as they are now, for "key" */
+int cache_store(const char *dir, uint64_t key, char **outputs, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,71 +5,54 @@
  * done with assertions, the parser does the validation and processing of the
  * input, if a returned object is not checked it is because it *must* exist (or
  * there is a bug in the grammar).
- * @note most values will be converted to doubles and then to integers, which
- * is fine for 32 bit values, but fails for large integers. */
+ * @note numbers are converted with the functions in num.h, a number that is
+ * too large for the field it is stored in is an error. */
 #include "can.h"
 #include "util.h"
+#include "arena.h"
+#include "intern.h"
+#include "index.h"
+#include "layout.h"
+#include "num.h"
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <inttypes.h>
 #include <math.h>
 
-static signal_t *signal_new(void)
+signal_t *signal_new(dbc_t *dbc)
 {
-	return allocate(sizeof(signal_t));
+	assert(dbc);
+	return arena_allocate(dbc->arena, sizeof(signal_t));
 }
 
-static void signal_delete(signal_t *signal)
+can_msg_t *can_msg_new(dbc_t *dbc)
 {
-	if (!signal)
-		return;
-	for (size_t i = 0; i < signal->ecu_count; i++)
-		free(signal->ecus[i]);
-	free(signal->name);
-	free(signal->ecus);
-	free(signal->units);
-	free(signal->muxed);
-	free(signal->mux_vals);
-	free(signal->comment);
-	free(signal);
+	assert(dbc);
+	return arena_allocate(dbc->arena, sizeof(can_msg_t));
 }
 
-static can_msg_t *can_msg_new(void)
+static unsigned long to_unsigned_long(const char *s, unsigned long max)
 {
-	return allocate(sizeof(can_msg_t));
+	assert(s);
+	uint64_t v = 0;
+	if (num_u64(s, strlen(s), &v) < 0 || v > max)
+		error("number out of range: %s", s);
+	return v;
 }
 
-static void can_msg_delete(can_msg_t *msg)
+static unsigned to_unsigned(const char *s)
 {
-	if (!msg)
-		return;
-	for (size_t i = 0; i < msg->signal_count; i++)
-		signal_delete(msg->sigs[i]);
-	free(msg->sigs);
-	free(msg->name);
-	free(msg->ecu);
-	free(msg->comment);
-	free(msg);
+	return to_unsigned_long(s, UINT_MAX);
 }
 
-static void val_delete(val_list_t *val)
+static double to_double(const char *s)
 {
-	if (!val)
-		return;
-	for (size_t i = 0; i < val->val_list_item_count; i++) {
-		free(val->val_list_items[i]->name);
-		free(val->val_list_items[i]);
-	}
-	free(val);
-}
-
-static void mul_val_delete(mul_val_list_t *mul_val)
-{
-	if (!mul_val)
-		return;
-	free(mul_val->multiplexed);
-	free(mul_val->multiplexor);
-	free(mul_val);
+	assert(s);
+	double d = 0;
+	if (num_double(s, strlen(s), &d) < 0)
+		error("number out of range: %s", s);
+	return d;
 }
 
 static void y_mx_c(mpc_ast_t *ast, signal_t *sig)
@@ -77,10 +60,8 @@ static void y_mx_c(mpc_ast_t *ast, signal_t *sig)
 	assert(ast && sig);
 	mpc_ast_t *scalar = ast->children[1];
 	mpc_ast_t *offset = ast->children[3];
-	int r = sscanf(scalar->contents, "%lf", &sig->scaling);
-	assert(r == 1);
-	r = sscanf(offset->contents, "%lf", &sig->offset);
-	assert(r == 1);
+	sig->scaling = to_double(scalar->contents);
+	sig->offset  = to_double(offset->contents);
 }
 
 static void range(mpc_ast_t *ast, signal_t *sig)
@@ -88,63 +69,91 @@ static void range(mpc_ast_t *ast, signal_t *sig)
 	assert(ast && sig);
 	mpc_ast_t *min = ast->children[1];
 	mpc_ast_t *max = ast->children[3];
-	int r = sscanf(min->contents, "%lf", &sig->minimum);
-	assert(r == 1);
-	r = sscanf(max->contents, "%lf", &sig->maximum);
-	assert(r == 1);
+	sig->minimum = to_double(min->contents);
+	sig->maximum = to_double(max->contents);
 }
 
-static void units(mpc_ast_t *ast, signal_t *sig)
+static void units(dbc_t *dbc, mpc_ast_t *ast, signal_t *sig)
 {
-	assert(ast && sig);
+	assert(dbc && ast && sig);
 	mpc_ast_t *unit = mpc_ast_get_child(ast, "regex");
-	sig->units = duplicate(unit->contents);
+	sig->units = intern_string(dbc->symbols, unit->contents);
 }
 
-static int sigval(mpc_ast_t *top, unsigned id, const char *signal)
+static void node(dbc_t *dbc, mpc_ast_t *ast, signal_t *sig)
 {
-	assert(top);
-	assert(signal);
+	assert(dbc && ast && sig);
+	sig->ecus = arena_grow(dbc->arena, sig->ecus, sig->ecu_count, sizeof(*sig->ecus));
+	sig->ecus[sig->ecu_count++] = intern_string(dbc->symbols, ast->contents);
+}
+
+/* A single receiving node is folded into the signal by the parser, a list
+ * of them is not */
+static void nodes(dbc_t *dbc, mpc_ast_t *ast, signal_t *sig)
+{
+	assert(dbc && ast && sig);
+	mpc_ast_t *single = mpc_ast_get_child(ast, "nodes|node|ident|regex");
+	if (single) {
+		node(dbc, single, sig);
+		return;
+	}
+	mpc_ast_t *list = mpc_ast_get_child(ast, "nodes|>");
+	if (!list)
+		return;
 	for (int i = 0; i >= 0;) {
-		i = mpc_ast_get_index_lb(top, "sigval|>", i);
+		i = mpc_ast_get_index_lb(list, "node|ident|regex", i);
 		if (i >= 0) {
-			mpc_ast_t *sv = mpc_ast_get_child_lb(top, "sigval|>", i);
-			mpc_ast_t *name   = mpc_ast_get_child(sv, "name|ident|regex");
-			mpc_ast_t *svid = mpc_ast_get_child(sv,   "id|integer|regex");
-			assert(name);
-			assert(svid);
-			unsigned svidd = 0;
-			sscanf(svid->contents, "%u", &svidd);
-			if (id == svidd && !strcmp(signal, name->contents)) {
-				unsigned typed = 0;
-				mpc_ast_t *type = mpc_ast_get_child(sv, "sigtype|integer|regex");
-				sscanf(type->contents, "%u", &typed);
-				debug("floating -> %s:%u:%u\n", name->contents, id, typed);
-				return typed;
-			}
+			node(dbc, mpc_ast_get_child_lb(list, "node|ident|regex", i), sig);
 			i++;
 		}
 	}
-	return -1;
 }
 
-static signal_t *ast2signal(mpc_ast_t *top, mpc_ast_t *ast, unsigned can_id)
+static int sigval(const index_t *sigvals, uint64_t id, const char *signal)
 {
-	int r;
+	assert(sigvals);
+	assert(signal);
+	sigval_t *sv = index_find(sigvals, id, signal);
+	if (!sv)
+		return -1;
+	debug("floating -> %s:%lu:%u\n", sv->name, (unsigned long)id, sv->type);
+	return sv->type;
+}
+
+static sigval_t *ast2sigval(dbc_t *dbc, mpc_ast_t *ast)
+{
+	assert(dbc);
+	assert(ast);
+	sigval_t *sv = arena_allocate(dbc->arena, sizeof(*sv));
+	mpc_ast_t *name = mpc_ast_get_child(ast, "name|ident|regex");
+	mpc_ast_t *id   = mpc_ast_get_child(ast, "id|integer|regex");
+	mpc_ast_t *type = mpc_ast_get_child(ast, "sigtype|integer|regex");
+	assert(name);
+	assert(id);
+	assert(type);
+	sv->id   = to_unsigned(id->contents);
+	sv->type = to_unsigned(type->contents);
+	sv->name = intern_string(dbc->symbols, name->contents);
+	return sv;
+}
+
+static signal_t *ast2signal(dbc_t *dbc, mpc_ast_t *ast)
+{
+	assert(dbc);
 	assert(ast);
-	signal_t *sig = signal_new();
+	signal_t *sig = signal_new(dbc);
 	mpc_ast_t *name   = mpc_ast_get_child(ast, "name|ident|regex");
 	mpc_ast_t *start  = mpc_ast_get_child(ast, "startbit|integer|regex");
 	mpc_ast_t *length = mpc_ast_get_child(ast, "length|regex");
 	mpc_ast_t *endianess = mpc_ast_get_child(ast, "endianess|char");
 	mpc_ast_t *sign   = mpc_ast_get_child(ast, "sign|char");
-	sig->name = duplicate(name->contents);
+	sig->name = intern_string(dbc->symbols, name->contents);
 	sig->val_list = NULL;
-	r = sscanf(start->contents, "%u", &sig->start_bit);
+	sig->start_bit = to_unsigned(start->contents);
 	/* BUG: Minor bug, an error should be returned here instead */
-	assert(r == 1 && sig->start_bit <= 64);
-	r = sscanf(length->contents, "%u", &sig->bit_length);
-	assert(r == 1 && sig->bit_length <= 64);
+	assert(sig->start_bit < (CAN_FD_MAX_DLC * 8));
+	sig->bit_length = to_unsigned(length->contents);
+	assert(sig->bit_length <= 64);
 	char endchar = endianess->contents[0];
 	assert(endchar == '0' || endchar == '1');
 	sig->endianess = endchar == '0' ?
@@ -156,8 +165,8 @@ static signal_t *ast2signal(mpc_ast_t *top, mpc_ast_t *ast, unsigned can_id)
 
 	y_mx_c(mpc_ast_get_child(ast, "y_mx_c|>"), sig);
 	range(mpc_ast_get_child(ast, "range|>"), sig);
-	units(mpc_ast_get_child(ast, "unit|string|>"), sig);
-	/*nodes(mpc_ast_get_child(ast, "nodes|node|ident|regex|>"), sig);*/
+	units(dbc, mpc_ast_get_child(ast, "unit|string|>"), sig);
+	nodes(dbc, ast, sig);
 
 	/* process multiplexed values, if present */
 	sig->mul_num = 0;
@@ -166,7 +175,7 @@ static signal_t *ast2signal(mpc_ast_t *top, mpc_ast_t *ast, unsigned can_id)
 	mpc_ast_t *multiplex = mpc_ast_get_child(ast, "multiplexor|>");
 	if (multiplex) {
 		sig->is_multiplexed = true;
-		sig->switchval = atol(multiplex->children[1]->contents);
+		sig->switchval = to_unsigned(multiplex->children[1]->contents);
 		mpc_ast_t *elem = mpc_ast_get_child_lb(multiplex, "char", 1);
 		if(elem && *elem->contents == 'M') {
 			sig->is_multiplexor = true;
@@ -178,45 +187,35 @@ static signal_t *ast2signal(mpc_ast_t *top, mpc_ast_t *ast, unsigned can_id)
 		sig->is_multiplexor = true;
 	}
 
-	sig->sigval = sigval(top, can_id, sig->name);
-	if (sig->sigval == 1 || sig->sigval == 2)
-		sig->is_floating = true;
-
-	debug("\tname => %s; start %u length %u %s %s %s",
-			sig->name, sig->start_bit, sig->bit_length, sig->units,
-			sig->endianess ? "intel" : "motorola",
-			sig->is_signed ? "signed " : "unsigned");
 	return sig;
 }
 
-static val_list_t *ast2val(mpc_ast_t *top, mpc_ast_t *ast)
+static val_list_t *ast2val(dbc_t *dbc, mpc_ast_t *ast)
 {
-	assert(top);
+	assert(dbc);
 	assert(ast);
-	val_list_t *val = allocate(sizeof(val_list_t));
+	val_list_t *val = arena_allocate(dbc->arena, sizeof(val_list_t));
 
 	mpc_ast_t *id   = mpc_ast_get_child(ast, "id|integer|regex");
-	int r = sscanf(id->contents,  "%u",  &val->id);
-	assert(r == 1);
+	val->id = to_unsigned(id->contents);
 
 	mpc_ast_t *name = mpc_ast_get_child(ast, "name|ident|regex");
-	val->name = duplicate(name->contents);
+	val->name = intern_string(dbc->symbols, name->contents);
 
-	val_list_item_t **items = allocate(sizeof(*items) * (ast->children_num+1));
+	val_list_item_t **items = arena_allocate(dbc->arena, sizeof(*items) * (ast->children_num+1));
 	int j = 0;
 	for (int i = 0; i >= 0;) {
 		i = mpc_ast_get_index_lb(ast, "val_item|>", i);
 		if (i >= 0) {
-			val_list_item_t *item = allocate(sizeof(val_list_item_t));
+			val_list_item_t *item = arena_allocate(dbc->arena, sizeof(val_list_item_t));
 			mpc_ast_t *val_item_ast = mpc_ast_get_child_lb(ast, "val_item|>", i);
 
 			mpc_ast_t *val_item_index = mpc_ast_get_child(val_item_ast, "integer|regex");
-			int r = sscanf(val_item_index->contents,  "%u",  &item->value);
-			assert(r == 1);
+			item->value = to_unsigned(val_item_index->contents);
 
 			mpc_ast_t *val_item_name = mpc_ast_get_child(val_item_ast, "string|>");
 			val_item_name = mpc_ast_get_child_lb(val_item_name, "regex", 1);
-			item->name = duplicate(val_item_name->contents);
+			item->name = intern_string(dbc->symbols, val_item_name->contents);
 			items[j++] = item;
 			i++;
 		}
@@ -225,51 +224,32 @@ static val_list_t *ast2val(mpc_ast_t *top, mpc_ast_t *ast)
 	val->val_list_item_count = j;
 	val->val_list_items = items;
 
-	// sort the value items by value
-	if (val->val_list_item_count) {
-		bool bFlip = false;
-		do {
-			bFlip = false;
-			for (size_t i = 0; i < val->val_list_item_count - 1; i++) {
-				if (val->val_list_items[i]->value > val->val_list_items[i + 1]->value) {
-					val_list_item_t *tmp = val->val_list_items[i];
-					val->val_list_items[i] = val->val_list_items[i + 1];
-					val->val_list_items[i + 1] = tmp;
-					bFlip = true;
-				}
-			}
-		} while (bFlip);
-	}
-
 	return val;
 }
 
-static mul_val_list_t *ast2mul_val(mpc_ast_t *top, mpc_ast_t *ast)
+static mul_val_list_t *ast2mul_val(dbc_t *dbc, mpc_ast_t *ast)
 {
-	assert(top);
+	assert(dbc);
 	assert(ast);
-	mul_val_list_t *mul_val = allocate(sizeof(mul_val_list_t));
+	mul_val_list_t *mul_val = arena_allocate(dbc->arena, sizeof(mul_val_list_t));
 
 	mpc_ast_t *id   = mpc_ast_get_child(ast, "id|integer|regex");
-	int r = sscanf(id->contents,  "%u",  &mul_val->id);
-	assert(r == 1);
+	mul_val->id = to_unsigned(id->contents);
 
 	int i =0;
 	i = mpc_ast_get_index_lb(ast, "name|ident|regex", i);
 	mpc_ast_t *multiplexed = mpc_ast_get_child_lb(ast, "name|ident|regex", i);
-	mul_val->multiplexed = duplicate(multiplexed->contents);
+	mul_val->multiplexed = intern_string(dbc->symbols, multiplexed->contents);
 
 	mpc_ast_t *multiplexor = mpc_ast_get_child_lb(ast, "name|ident|regex", i+1);
-	mul_val->multiplexor = duplicate(multiplexor->contents);
+	mul_val->multiplexor = intern_string(dbc->symbols, multiplexor->contents);
 
 	i = mpc_ast_get_index_lb(ast, "integer|regex", i);
 	mpc_ast_t *first_value = mpc_ast_get_child_lb(ast, "integer|regex", i);
-	r = sscanf(first_value->contents,  "%u",  &mul_val->min_value);
-	assert(r == 1);
+	mul_val->min_value = to_unsigned(first_value->contents);
 
 	mpc_ast_t *second_value = mpc_ast_get_child_lb(ast, "integer|regex", i+1);
-	r = sscanf(second_value->contents,  "%u",  &mul_val->max_value);
-	assert(r == 1);
+	mul_val->max_value = to_unsigned(second_value->contents);
 
 	// swap inverted values
 	if (mul_val->min_value > mul_val->max_value) {
@@ -281,21 +261,19 @@ static mul_val_list_t *ast2mul_val(mpc_ast_t *top, mpc_ast_t *ast)
 	return mul_val;
 }
 
-static can_msg_t *ast2msg(mpc_ast_t *top, mpc_ast_t *ast, dbc_t *dbc)
+static can_msg_t *ast2msg(dbc_t *dbc, mpc_ast_t *ast)
 {
-	assert(top);
+	assert(dbc);
 	assert(ast);
-	can_msg_t *c = can_msg_new();
+	can_msg_t *c = can_msg_new(dbc);
 	mpc_ast_t *name = mpc_ast_get_child(ast, "name|ident|regex");
 	mpc_ast_t *ecu  = mpc_ast_get_child(ast, "ecu|ident|regex");
 	mpc_ast_t *dlc  = mpc_ast_get_child(ast, "dlc|integer|regex");
 	mpc_ast_t *id   = mpc_ast_get_child(ast, "id|integer|regex");
-	c->name = duplicate(name->contents);
-	c->ecu  = duplicate(ecu->contents);
-	int r = sscanf(dlc->contents, "%u", &c->dlc);
-	assert(r == 1);
-	r = sscanf(id->contents,  "%lu", &c->id);
-	assert(r == 1);
+	c->name = intern_string(dbc->symbols, name->contents);
+	c->ecu  = intern_string(dbc->symbols, ecu->contents);
+	c->dlc = to_unsigned(dlc->contents);
+	c->id  = to_unsigned_long(id->contents, ULONG_MAX);
 
 	/* Extended CAN messages use the top most bit (which should
 	 * not normally be set) to indicate that they are extended
@@ -310,52 +288,97 @@ static can_msg_t *ast2msg(mpc_ast_t *top, mpc_ast_t *ast, dbc_t *dbc)
 		}
 	//}
 
-	signal_t **signal_s = allocate(sizeof(*signal_s));
-	size_t len = 1, j = 0;
 	for (int i = 0; i >= 0;) {
 		i = mpc_ast_get_index_lb(ast, "signal|>", i);
 		if (i >= 0) {
 			mpc_ast_t *sig_ast = mpc_ast_get_child_lb(ast, "signal|>", i);
-			signal_s = reallocator(signal_s, sizeof(*signal_s)*++len);
-			signal_s[j++] = ast2signal(top, sig_ast, c->id);
+			c->sigs = arena_grow(dbc->arena, c->sigs, c->signal_count, sizeof(*c->sigs));
+			c->sigs[c->signal_count++] = ast2signal(dbc, sig_ast);
 			i++;
 		}
 	}
+	return c;
+}
+
+/* SG_MUL_VAL_ records for a signal, in the order they appear in the file */
+typedef struct mul_vals_t {
+	mul_val_list_t *mul_val;
+	struct mul_vals_t *next, *last;
+} mul_vals_t;
+
+/* The records that refer to signals are indexed once per file, by message
+ * identifier and signal name, instead of searched for every signal. */
+typedef struct {
+	index_t *sigvals;  /**< first sigval_t for a signal */
+	index_t *vals;     /**< first val_list_t for a signal */
+	index_t *mul_vals; /**< all mul_vals_t for a multiplexed signal */
+	index_t *signals;  /**< signals by message and name, if there are mul_vals */
+} resolve_t;
+
+static void multiplex(dbc_t *dbc, const resolve_t *x, can_msg_t *c, signal_t *sig, const mul_vals_t *mv)
+{
+	assert(dbc);
+	assert(x);
+	assert(c);
+	assert(sig);
+	assert(mv);
+	for (; mv; mv = mv->next) {
+		mul_val_list_t *m = mv->mul_val;
+		if (sig->switchval > m->max_value || sig->switchval < m->min_value)
+			error("The multiplex value is wrong on message %s for signal %s (fix your DBC file)", c->name, sig->name);
+
+		sig->is_multiplexed = true;
+
+		signal_t *mux = index_find(x->signals, (uintptr_t)c, m->multiplexor);
+		if (mux) { // I assume a signal can be multiplexed by only one signal
+			size_t last = mux->mul_num++;
+			mux->muxed = arena_grow(dbc->arena, mux->muxed, last, sizeof(signal_t*));
+			mux->mux_vals = arena_grow(dbc->arena, mux->mux_vals, last, sizeof(mul_val_list_t*));
+			mux->muxed[last] = sig;
+			mux->mux_vals[last] = m;
+		}
+	}
+}
 
-	c->sigs = signal_s;
-	c->signal_count = j;
+/* Records name extended messages with bit 31 of their identifier set, they
+ * are indexed and looked up with this identifier. */
+static uint64_t record_id(const can_msg_t *c)
+{
+	assert(c);
+	return c->id | (unsigned long)c->is_extended << 31;
+}
+
+static void msg_resolve(dbc_t *dbc, const resolve_t *x, can_msg_t *c)
+{
+	assert(dbc);
+	assert(x);
+	assert(c);
+
+	const uint64_t mux_id = record_id(c);
+	for (size_t i = 0; i < c->signal_count; i++) {
+		signal_t *sig = c->sigs[i];
+		sig->sigval = sigval(x->sigvals, mux_id, sig->name);
+		if (sig->sigval == 1 || sig->sigval == 2)
+			sig->is_floating = true;
+
+		debug("\tname => %s; start %u length %u %s %s %s",
+				sig->name, sig->start_bit, sig->bit_length, sig->units,
+				sig->endianess ? "intel" : "motorola",
+				sig->is_signed ? "signed " : "unsigned");
+	}
 
 	// assign val-s to the signals
 	for (size_t i = 0; i < c->signal_count; i++) {
-		for (size_t j = 0; j<dbc->val_count; j++) {
-			if (dbc->vals[j]->id == c->id && strcmp(dbc->vals[j]->name, c->sigs[i]->name) == 0) {
-				c->sigs[i]->val_list = dbc->vals[j];
-				break;
-			}
-		}
+		val_list_t *val = index_find(x->vals, mux_id, c->sigs[i]->name);
+		if (val)
+			c->sigs[i]->val_list = val;
 	}
 
 	// assign multiplexed signals to multiplexors
 	for (size_t i = 0; i < c->signal_count; i++) {
-		for (size_t j = 0; j<dbc->mul_val_count; j++) {
-			if (dbc->mul_vals[j]->id == (c->id | (unsigned long)c->is_extended << 31) && strcmp(dbc->mul_vals[j]->multiplexed, c->sigs[i]->name) == 0) {
-				if (c->sigs[i]->switchval > dbc->mul_vals[j]->max_value || c->sigs[i]->switchval < dbc->mul_vals[j]->min_value)
-					error("The multiplex value is wrong on message %s for signal %s (fix your DBC file)", c->name, c->sigs[i]->name);
-
-				c->sigs[i]->is_multiplexed = true;
-
-				for(size_t k = 0; k < c->signal_count; k++) {
-					if (strcmp(c->sigs[k]->name, dbc->mul_vals[j]->multiplexor) == 0) {
-						size_t last = c->sigs[k]->mul_num++;
-						c->sigs[k]->muxed = reallocator(c->sigs[k]->muxed, sizeof(signal_t*) * c->sigs[k]->mul_num);
-						c->sigs[k]->mux_vals = reallocator(c->sigs[k]->mux_vals, sizeof(mul_val_list_t*) * c->sigs[k]->mul_num);
-						c->sigs[k]->muxed[last] = c->sigs[i];
-						c->sigs[k]->mux_vals[last] = dbc->mul_vals[j];
-						break; // I assume a signal can be multiplexed by only one signal
-					}
-				}
-			}
-		}
+		const mul_vals_t *mv = index_find(x->mul_vals, mux_id, c->sigs[i]->name);
+		if (mv)
+			multiplex(dbc, x, c, c->sigs[i], mv);
 	}
 
 	if (c->signal_count > 1) { // Lets sort the signals so that their start_bit is asc (lowest number first)
@@ -374,52 +397,282 @@ static can_msg_t *ast2msg(mpc_ast_t *top, mpc_ast_t *ast, dbc_t *dbc)
 	}
 
 	debug("%s id:%u dlc:%u signals:%zu ecu:%s", c->name, c->id, c->dlc, c->signal_count, c->ecu);
-	return c;
+}
+
+static void val_sort(val_list_t *val)
+{
+	assert(val);
+	// sort the value items by value
+	if (val->val_list_item_count) {
+		bool bFlip = false;
+		do {
+			bFlip = false;
+			for (size_t i = 0; i < val->val_list_item_count - 1; i++) {
+				if (val->val_list_items[i]->value > val->val_list_items[i + 1]->value) {
+					val_list_item_t *tmp = val->val_list_items[i];
+					val->val_list_items[i] = val->val_list_items[i + 1];
+					val->val_list_items[i + 1] = tmp;
+					bFlip = true;
+				}
+			}
+		} while (bFlip);
+	}
+}
+
+void dbc_resolve(dbc_t *dbc)
+{
+	assert(dbc);
+	dbc->use_float = dbc->sigval_count > 0;
+	for (size_t i = 0; i < dbc->val_count; i++)
+		val_sort(dbc->vals[i]);
+	/* the indexes are only needed here, so come from an arena of their own */
+	arena_t *scratch = arena_new();
+	resolve_t x = {
+		.sigvals  = index_new(scratch, dbc->sigval_count),
+		.vals     = index_new(scratch, dbc->val_count),
+		.mul_vals = index_new(scratch, dbc->mul_val_count),
+	};
+	for (size_t i = 0; i < dbc->sigval_count; i++) {
+		sigval_t *sv = dbc->sigvals[i];
+		(void)index_add(x.sigvals, sv->id, sv->name, sv);
+	}
+	for (size_t i = 0; i < dbc->val_count; i++) {
+		val_list_t *val = dbc->vals[i];
+		(void)index_add(x.vals, val->id, val->name, val);
+	}
+	for (size_t i = 0; i < dbc->mul_val_count; i++) {
+		mul_vals_t *mv = arena_allocate(scratch, sizeof(*mv));
+		mv->mul_val = dbc->mul_vals[i];
+		mv->last = mv;
+		mul_vals_t *first = index_add(x.mul_vals, mv->mul_val->id, mv->mul_val->multiplexed, mv);
+		if (first != mv) {
+			first->last->next = mv;
+			first->last = mv;
+		}
+	}
+	/* the multiplexor of a signal is looked up by name within its message,
+	 * before the signals are sorted */
+	if (dbc->mul_val_count) {
+		size_t signal_count = 0;
+		for (size_t i = 0; i < dbc->message_count; i++)
+			signal_count += dbc->messages[i]->signal_count;
+		x.signals = index_new(scratch, signal_count);
+		for (size_t i = 0; i < dbc->message_count; i++) {
+			can_msg_t *c = dbc->messages[i];
+			for (size_t j = 0; j < c->signal_count; j++)
+				(void)index_add(x.signals, (uintptr_t)c, c->sigs[j]->name, c->sigs[j]);
+		}
+	}
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *c = dbc->messages[i];
+		msg_resolve(dbc, &x, c);
+		c->layout = layout_message(dbc, c);
+	}
+	arena_delete(scratch);
 }
 
 dbc_t *dbc_new(void)
 {
-	return allocate(sizeof(dbc_t));
+	arena_t *arena = arena_new();
+	dbc_t *dbc = arena_allocate(arena, sizeof(dbc_t));
+	dbc->arena = arena;
+	dbc->symbols = intern_new(arena);
+	return dbc;
 }
 
 void dbc_delete(dbc_t *dbc)
 {
 	if (!dbc)
 		return;
-	for (size_t i = 0; i < dbc->message_count; i++)
-		can_msg_delete(dbc->messages[i]);
-
-	for (size_t i = 0; i < dbc->val_count; i++)
-		val_delete(dbc->vals[i]);
+	debug("symbols: %zu unique", intern_count(dbc->symbols));
+	/* a database loaded from a binary image lives in it, and the mapping
+	 * is allocated from the arena */
+	mapping_t image = { .data = NULL, };
+	if (dbc->image)
+		image = *(mapping_t*)dbc->image;
+	arena_delete(dbc->arena);
+	if (image.data)
+		unmap_file(&image);
+}
 
-	for (size_t i = 0; i < dbc->mul_val_count; i++)
-		mul_val_delete(dbc->mul_vals[i]);
+/* Messages are checked for collisions in two indexes, identifiers are
+ * keyed by bus and names by their interned copy in the merged database. */
+static int merge_message(dbc_t *d, index_t *ids, index_t *names, arena_t *scratch, can_msg_t *c)
+{
+	assert(d);
+	assert(ids);
+	assert(names);
+	assert(scratch);
+	assert(c);
+	const char *bus = d->buses[c->bus];
+	const uint64_t key = ((uint64_t)c->bus << 32) | c->id;
+	can_msg_t *o = index_add(ids, key, NULL, c);
+	if (o != c) {
+		warning("bus '%s': messages '%s' and '%s' have the same identifier 0x%lx", bus, o->name, c->name, c->id);
+		return -1;
+	}
+	char *name = intern_string(d->symbols, c->name);
+	o = index_add(names, 0, name, c);
+	if (o != c) {
+		const size_t length = strlen(bus) + strlen(name) + 2;
+		char *renamed = arena_allocate(scratch, length);
+		snprintf(renamed, length, "%s_%s", bus, name);
+		note("bus '%s': message '%s' is also on bus '%s', renamed to '%s'", bus, name, d->buses[o->bus], renamed);
+		name = intern_string(d->symbols, renamed);
+		o = index_add(names, 0, name, c);
+		if (o != c) {
+			warning("bus '%s': renamed message '%s' is already in use", bus, name);
+			return -1;
+		}
+	}
+	c->name = name;
+	return 0;
+}
 
-	free(dbc);
+static char *reintern(dbc_t *d, char *s)
+{
+	assert(d);
+	return s ? intern_string(d->symbols, s) : NULL;
 }
 
-void assign_comment_to_signal(dbc_t *dbc, const char *comment, unsigned message_id, const char * signal_name)
+/* The strings of a part are interned again in the merged database, so that
+ * they can be compared by pointer with those of the other parts. Message
+ * names are interned by merge_message, as they may be renamed. */
+static void merge_strings(dbc_t *d, dbc_t *p)
 {
-	for (size_t i = 0; i<dbc->message_count; i++) {
-		if (dbc->messages[i]->id == message_id) {
-			for (size_t j = 0; j<dbc->messages[i]->signal_count; j++) {
-				if (strcmp(dbc->messages[i]->sigs[j]->name, signal_name) == 0) {
-					dbc->messages[i]->sigs[j]->comment = duplicate(comment);
-					return;
-				}
-			}
+	assert(d);
+	assert(p);
+	for (size_t i = 0; i < p->message_count; i++) {
+		can_msg_t *c = p->messages[i];
+		c->ecu = reintern(d, c->ecu);
+		for (size_t j = 0; j < c->signal_count; j++) {
+			signal_t *sig = c->sigs[j];
+			sig->name  = reintern(d, sig->name);
+			sig->units = reintern(d, sig->units);
+			for (size_t k = 0; k < sig->ecu_count; k++)
+				sig->ecus[k] = reintern(d, sig->ecus[k]);
 		}
 	}
+	for (size_t i = 0; i < p->val_count; i++) {
+		val_list_t *val = p->vals[i];
+		val->name = reintern(d, val->name);
+		for (size_t j = 0; j < val->val_list_item_count; j++)
+			val->val_list_items[j]->name = reintern(d, val->val_list_items[j]->name);
+	}
+	for (size_t i = 0; i < p->mul_val_count; i++) {
+		p->mul_vals[i]->multiplexed = reintern(d, p->mul_vals[i]->multiplexed);
+		p->mul_vals[i]->multiplexor = reintern(d, p->mul_vals[i]->multiplexor);
+	}
+	for (size_t i = 0; i < p->sigval_count; i++)
+		p->sigvals[i]->name = reintern(d, p->sigvals[i]->name);
 }
 
-void assign_comment_to_message(dbc_t *dbc, const char *comment, unsigned message_id)
+dbc_t *dbc_merge(dbc_t **parts, const char **buses, size_t count)
 {
-	for (size_t i = 0; i<dbc->message_count; i++) {
-		if (dbc->messages[i]->id == message_id) {
-			dbc->messages[i]->comment = duplicate(comment);
-			return;
+	assert(parts);
+	assert(buses);
+	dbc_t *d = dbc_new();
+	d->bus_count = count;
+	d->buses = arena_allocate(d->arena, sizeof(*d->buses) * (count + 1));
+	size_t messages = 0, vals = 0, mul_vals = 0, sigvals = 0;
+	for (size_t i = 0; i < count; i++) {
+		assert(parts[i]);
+		assert(!parts[i]->image);
+		d->buses[i] = intern_string(d->symbols, buses[i]);
+		messages += parts[i]->message_count;
+		vals     += parts[i]->val_count;
+		mul_vals += parts[i]->mul_val_count;
+		sigvals  += parts[i]->sigval_count;
+	}
+	d->messages = arena_allocate(d->arena, sizeof(*d->messages) * (messages + 1));
+	d->vals     = arena_allocate(d->arena, sizeof(*d->vals)     * (vals + 1));
+	d->mul_vals = arena_allocate(d->arena, sizeof(*d->mul_vals) * (mul_vals + 1));
+	d->sigvals  = arena_allocate(d->arena, sizeof(*d->sigvals)  * (sigvals + 1));
+
+	/* the parts are moved into the arena of the merged database, which
+	 * keeps everything they point to alive */
+	for (size_t i = 0; i < count; i++) {
+		dbc_t *p = parts[i];
+		merge_strings(d, p);
+		for (size_t j = 0; j < p->message_count; j++)
+			p->messages[j]->bus = i;
+		if (p->message_count)
+			memcpy(d->messages + d->message_count, p->messages, p->message_count * sizeof(*p->messages));
+		if (p->val_count)
+			memcpy(d->vals + d->val_count, p->vals, p->val_count * sizeof(*p->vals));
+		if (p->mul_val_count)
+			memcpy(d->mul_vals + d->mul_val_count, p->mul_vals, p->mul_val_count * sizeof(*p->mul_vals));
+		if (p->sigval_count)
+			memcpy(d->sigvals + d->sigval_count, p->sigvals, p->sigval_count * sizeof(*p->sigvals));
+		d->message_count += p->message_count;
+		d->val_count     += p->val_count;
+		d->mul_val_count += p->mul_val_count;
+		d->sigval_count  += p->sigval_count;
+		d->use_float     = d->use_float || p->use_float;
+		arena_adopt(d->arena, p->arena);
+	}
+
+	arena_t *scratch = arena_new();
+	index_t *ids = index_new(scratch, messages);
+	index_t *names = index_new(scratch, (messages * 2) + count);
+	int r = 0;
+	/* buses are keyed apart from messages, which can share their names */
+	for (size_t i = 0; r == 0 && i < count; i++) {
+		if (index_add(names, 1, d->buses[i], &d->buses[i]) != &d->buses[i]) {
+			warning("bus '%s' is given more than once", d->buses[i]);
+			r = -1;
 		}
 	}
+	for (size_t i = 0; r == 0 && i < d->message_count; i++)
+		r = merge_message(d, ids, names, scratch, d->messages[i]);
+	arena_delete(scratch);
+	if (r < 0) {
+		dbc_delete(d);
+		return NULL;
+	}
+	debug("merged %zu messages from %zu buses", d->message_count, count);
+	return d;
+}
+
+/* Comments are looked up by message identifier and signal name, in
+ * indexes that are built on first use, which must be after dbc_resolve as
+ * the first signal with a name (in start bit order) is the one used. */
+static void comment_index(dbc_t *dbc)
+{
+	assert(dbc);
+	if (dbc->message_index)
+		return;
+	size_t signal_count = 0;
+	for (size_t i = 0; i < dbc->message_count; i++)
+		signal_count += dbc->messages[i]->signal_count;
+	dbc->message_index = index_new(dbc->arena, dbc->message_count);
+	dbc->signal_index = index_new(dbc->arena, signal_count);
+	for (size_t i = 0; i < dbc->message_count; i++) {
+		can_msg_t *c = dbc->messages[i];
+		(void)index_add(dbc->message_index, record_id(c), NULL, c);
+		for (size_t j = 0; j < c->signal_count; j++)
+			(void)index_add(dbc->signal_index, record_id(c), c->sigs[j]->name, c->sigs[j]);
+	}
+}
+
+void assign_comment_to_signal(dbc_t *dbc, const char *comment, unsigned message_id, const char * signal_name)
+{
+	/* a name that has not been interned cannot belong to any signal */
+	const char *name = intern_find(dbc->symbols, signal_name, strlen(signal_name));
+	if (!name)
+		return;
+	comment_index(dbc);
+	signal_t *sig = index_find(dbc->signal_index, message_id, name);
+	if (sig)
+		sig->comment = arena_duplicate(dbc->arena, comment);
+}
+
+void assign_comment_to_message(dbc_t *dbc, const char *comment, unsigned message_id)
+{
+	comment_index(dbc);
+	can_msg_t *c = index_find(dbc->message_index, message_id, NULL);
+	if (c)
+		c->comment = arena_duplicate(dbc->arena, comment);
 }
 
 dbc_t *ast2dbc(mpc_ast_t *ast)
@@ -431,14 +684,14 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 	mpc_ast_t *vals_ast = mpc_ast_get_child_lb(ast, "vals|>", 0);
 	if (vals_ast) {
 		d->val_count = vals_ast->children_num;
-		d->vals = allocate(sizeof(*d->vals) * (d->val_count+1));
+		d->vals = arena_allocate(d->arena, sizeof(*d->vals) * (d->val_count+1));
 		if (d->val_count) {
 			int j = 0;
 			for (int i = 0; i >= 0;) {
 				i = mpc_ast_get_index_lb(vals_ast, "val|>", i);
 				if (i >= 0) {
 					mpc_ast_t *val_ast = mpc_ast_get_child_lb(vals_ast, "val|>", i);
-					d->vals[j++] = ast2val(ast, val_ast);
+					d->vals[j++] = ast2val(d, val_ast);
 					i++;
 				}
 			}
@@ -446,9 +699,9 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 	} else {
 		mpc_ast_t *val_ast = mpc_ast_get_child_lb(ast, "vals|val|>", 0);
 		if (val_ast) {
-			d->vals = allocate(sizeof(*d->vals) * (d->val_count+1));
+			d->vals = arena_allocate(d->arena, sizeof(*d->vals) * (d->val_count+1));
 			d->val_count = 1;
-			d->vals[0] = ast2val(ast, val_ast);
+			d->vals[0] = ast2val(d, val_ast);
 		}
 	}
 
@@ -457,14 +710,14 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 	mpc_ast_t *mul_vals_ast = mpc_ast_get_child_lb(ast, "mul_vals|>", 0);
 	if (mul_vals_ast) {
 		d->mul_val_count = mul_vals_ast->children_num;
-		d->mul_vals = allocate(sizeof(*d->mul_vals) * (d->mul_val_count));
+		d->mul_vals = arena_allocate(d->arena, sizeof(*d->mul_vals) * (d->mul_val_count));
 		if (d->mul_val_count) {
 			int j = 0;
 			for (int i = 0; i >= 0;) {
 				i = mpc_ast_get_index_lb(mul_vals_ast, "mul_val|>", i);
 				if (i >= 0) {
 					mpc_ast_t *mul_val_ast = mpc_ast_get_child_lb(mul_vals_ast, "mul_val|>", i);
-					d->mul_vals[j++] = ast2mul_val(ast, mul_val_ast);
+					d->mul_vals[j++] = ast2mul_val(d, mul_val_ast);
 					i++;
 				}
 			}
@@ -473,8 +726,20 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 		mpc_ast_t *mul_val_ast = mpc_ast_get_child_lb(ast, "mul_vals|mul_val|>", 0);
 		if (mul_val_ast) {
 			d->mul_val_count = 1;
-			d->mul_vals = allocate(sizeof(*d->mul_vals));
-			d->mul_vals[0] = ast2mul_val(ast, mul_val_ast);
+			d->mul_vals = arena_allocate(d->arena, sizeof(*d->mul_vals));
+			d->mul_vals[0] = ast2mul_val(d, mul_val_ast);
+		}
+	}
+
+	/* find and store the signal value types, they are needed to resolve
+	signals once all messages have been read in */
+	for (int i = 0; i >= 0;) {
+		i = mpc_ast_get_index_lb(ast, "sigval|>", i);
+		if (i >= 0) {
+			mpc_ast_t *sv = mpc_ast_get_child_lb(ast, "sigval|>", i);
+			d->sigvals = arena_grow(d->arena, d->sigvals, d->sigval_count, sizeof(*d->sigvals));
+			d->sigvals[d->sigval_count++] = ast2sigval(d, sv);
+			i++;
 		}
 	}
 
@@ -482,31 +747,30 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 	mpc_ast_t *msgs_ast = mpc_ast_get_child_lb(ast, "messages|>", 0);
 	if (index < 0) {
 		warning("no messages found");
+		dbc_delete(d);
 		return NULL;
 	}
 
 	int n = msgs_ast->children_num;
 	if (n <= 0) {
 		warning("messages has no children");
+		dbc_delete(d);
 		return NULL;
 	}
 
-	can_msg_t **r = allocate(sizeof(*r) * (n+1));
+	can_msg_t **r = arena_allocate(d->arena, sizeof(*r) * (n+1));
 	int j = 0;
 	for (int i = 0; i >= 0;) {
 		i = mpc_ast_get_index_lb(msgs_ast, "message|>", i);
 		if (i >= 0) {
 			mpc_ast_t *msg_ast = mpc_ast_get_child_lb(msgs_ast, "message|>", i);
-			r[j++] = ast2msg(ast, msg_ast, d);
+			r[j++] = ast2msg(d, msg_ast);
 			i++;
 		}
 	}
 	d->message_count = j;
 	d->messages = r;
-
-	int i = mpc_ast_get_index_lb(ast, "sigval|>", 0);
-	if (i >= 0)
-		d->use_float = true;
+	dbc_resolve(d);
 
 	// find and store the vals into the dbc: they will be assigned to
 	// signals later
@@ -516,14 +780,12 @@ dbc_t *ast2dbc(mpc_ast_t *ast)
 			i = mpc_ast_get_index_lb(comments_ast, "comment|>", i);
 			if (i >= 0) {
 				mpc_ast_t *comment_ast = mpc_ast_get_child_lb(comments_ast, "comment|>", i);
-				if (comments_ast && comments_ast->children_num > 3) {
+				if (comment_ast->children_num > 3) {
 					bool to_message = strcmp(comment_ast->children[2]->contents, "BO_") == 0;
 					bool to_signal = strcmp(comment_ast->children[2]->contents, "SG_") == 0;
 					if (to_signal || to_message) {
 						mpc_ast_t *id   = mpc_ast_get_child(comment_ast, "id|integer|regex");
-						unsigned message_id;
-						int r = sscanf(id->contents, "%u", &message_id);
-						assert(r == 1);
+						const unsigned message_id = to_unsigned(id->contents);
 						mpc_ast_t *comment = mpc_ast_get_child(comment_ast, "comment_string|string|>");
 						if (to_signal) {
 							mpc_ast_t *signal_name = mpc_ast_get_child(comment_ast, "name|ident|regex");
@@ -11,6 +11,12 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include "mpc.h"
+#include "arena.h"
+#include "intern.h"
+#include "index.h"
+
+#define CAN_MAX_DLC    (8u)  /**< largest payload of a classic CAN message, in bytes */
+#define CAN_FD_MAX_DLC (64u) /**< largest payload of a CAN-FD message, in bytes */
 
 typedef enum {
 	endianess_motorola_e = 0,
@@ -43,6 +49,12 @@ typedef struct {
 	unsigned id;   /**< identifier, 11 or 29 bit */
 } mul_val_list_t;
 
+typedef struct {
+	unsigned id;   /**< identifier of the message the signal belongs to */
+	char *name;    /**< name of the signal */
+	unsigned type; /**< 1 == float, 2 == double */
+} sigval_t;
+
 typedef struct signal_t signal_t;
 
 struct signal_t {
@@ -65,6 +77,7 @@ struct signal_t {
 	unsigned switchval;  /**< if is_multiplexed, this will contain the
 				   value that decodes this signal for the multiplexor */
 	val_list_t *val_list;
+	unsigned layout;     /**< LAYOUT_* flags, see layout.h */
 	size_t mul_num;      /**< number of multiplexed signals */
 	signal_t **muxed;    /**< list of multiplexed signals */
 	mul_val_list_t **mux_vals; /**< list of mux_vals relative to signals */
@@ -75,12 +88,13 @@ typedef struct {
 	char *name;          /**< can message name */
 	char *ecu;           /**< name of ECU */
 	signal_t **sigs;     /**< signals that can decode/encode this message*/
-	uint64_t data;       /**< data, up to eight bytes, not used for generation */
 	size_t signal_count; /**< number of signals */
-	unsigned dlc;        /**< length of CAN message 0-8 bytes */
+	unsigned dlc;        /**< length of CAN message 0-8 bytes, or up to 64 for CAN-FD */
 	unsigned long id;    /**< identifier, 11 or 29 bit */
 	bool is_extended;    /**< is extended mode message (29bit) */
+	unsigned bus;        /**< bus the message is on, an index into dbc_t.buses */
 	char *comment;
+	struct layout_t *layout; /**< occupancy of the payload, see layout.h */
 } can_msg_t;
 
 typedef struct {
@@ -91,11 +105,40 @@ typedef struct {
 	val_list_t **vals;    /**< value list; used for enumerations in DBC file */
 	size_t mul_val_count; /**< count of mul_vals*/
 	mul_val_list_t **mul_vals; /**< multiplexed value list; used for multiplexed signals in DBC file */
+	size_t sigval_count;  /**< count of sigvals */
+	sigval_t **sigvals;   /**< signal value types (SIG_VALTYPE_); used for floating point signals */
 	int version;          /**< version information used for generating files (not just C) */
+	size_t bus_count;     /**< count of buses, zero unless made by dbc_merge */
+	char **buses;         /**< name of each bus */
+	arena_t *arena;       /**< everything belonging to this database is allocated from here */
+	intern_t *symbols;    /**< names, units and ECUs are interned here, compare them by pointer */
+	index_t *message_index; /**< messages by identifier, built when the first comment is assigned */
+	index_t *signal_index;  /**< signals by message identifier and name, as above */
+	struct compiled_t *compiled; /**< compiled view, see dbc_compile in compile.h */
+	void *image;          /**< mapping_t of a binary database this lives in, see 2dbcb.h */
 } dbc_t;
 
 dbc_t *ast2dbc(mpc_ast_t *ast);
+dbc_t *dbc_new(void);
 void dbc_delete(dbc_t *dbc);
+can_msg_t *can_msg_new(dbc_t *dbc);
+signal_t *signal_new(dbc_t *dbc);
+
+/* dbc_resolve must be called once all messages, vals, mul_vals and sigvals
+ * have been read in, it links them together, sorts the signals and works
+ * out the layout of each message (see layout.h). */
+void dbc_resolve(dbc_t *dbc);
+void assign_comment_to_signal(dbc_t *dbc, const char *comment, unsigned message_id, const char *signal_name);
+void assign_comment_to_message(dbc_t *dbc, const char *comment, unsigned message_id);
+
+/* dbc_merge combines resolved databases into one, each part becomes a bus
+ * numbered in order and named by "buses", which must be usable in C
+ * identifiers. The parts are consumed even if merging fails. Messages with
+ * the same identifier on the same bus are an error, a message with the name
+ * of one on an earlier bus is renamed by prefixing it with its bus name.
+ * The strings of the parts are interned again in the merged database.
+ * Databases loaded from binary images cannot be merged. */
+dbc_t *dbc_merge(dbc_t **parts, const char **buses, size_t count);
 
 #ifdef __cplusplus
 }
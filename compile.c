@@ -0,0 +1,224 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief Compile a resolved database into a contiguous table of the fields
+ * needed to pack and unpack signals, see compile.h. */
+#include "compile.h"
+#include "layout.h"
+#include "util.h"
+#include <assert.h>
+#include <string.h>
+
+bool compiled_is_fd(const can_msg_t *msg)
+{
+	assert(msg);
+	if (msg->dlc > CAN_MAX_DLC)
+		return true;
+	if (!msg->layout)
+		return false;
+	for (unsigned b = CAN_MAX_DLC; b < LAYOUT_BYTES; b++)
+		if (msg->layout->used[b])
+			return true;
+	return false;
+}
+
+unsigned compiled_shift(bool motorola, unsigned start_bit, unsigned bit_length)
+{
+	assert(start_bit < 64);
+	assert(!motorola || (8 * (7 - (start_bit / 8))) + (start_bit % 8) + 1 >= bit_length);
+	if (motorola)
+		start_bit = (8 * (7 - (start_bit / 8))) + (start_bit % 8) - (bit_length - 1);
+	return start_bit;
+}
+
+uint64_t compiled_mask(unsigned bit_length)
+{
+	assert(bit_length <= 64);
+	return bit_length == 64 ?
+		0xFFFFFFFFFFFFFFFFuLL :
+		(1uLL << bit_length) - 1uLL;
+}
+
+unsigned compiled_floating(const compiled_signal_t *s)
+{
+	assert(s);
+	if (s->flags & COMPILED_DOUBLE)
+		return 2;
+	return s->flags & COMPILED_FLOAT ? 1 : 0;
+}
+
+/* The bytes a signal occupies in a payload, "bytes" is at most nine. Motorola
+ * signals count their bits from the most significant bit of the first byte. */
+static void compile_span(compiled_signal_t *s, bool motorola)
+{
+	assert(s);
+	s->first = s->start_bit / 8;
+	if (s->bit_length == 0)
+		return;
+	if (motorola) {
+		const unsigned lsb = (s->first * 8u) + 7u - (s->start_bit % 8u) + s->bit_length - 1u;
+		s->bytes = (lsb / 8) - s->first + 1;
+		s->bytes_shift = 7 - (lsb % 8);
+	} else {
+		s->bytes = ((s->start_bit + s->bit_length - 1u) / 8) - s->first + 1;
+		s->bytes_shift = s->start_bit % 8;
+	}
+	assert(s->bytes <= 9);
+}
+
+static void compile_signal(compiled_signal_t *s, compiled_meta_t *m, signal_t *sig, bool fd)
+{
+	assert(s);
+	assert(m);
+	assert(sig);
+	const bool motorola = sig->endianess == endianess_motorola_e;
+	s->mask       = compiled_mask(sig->bit_length);
+	s->sign       = sig->is_signed && !sig->is_floating && sig->bit_length ? 1uLL << (sig->bit_length - 1) : 0;
+	s->scaling    = sig->scaling;
+	s->offset     = sig->offset;
+	s->minimum    = sig->minimum;
+	s->maximum    = sig->maximum;
+	s->switchval  = sig->switchval;
+	s->start_bit  = sig->start_bit;
+	s->bit_length = sig->bit_length;
+	s->shift      = fd ? 0 : compiled_shift(motorola, sig->start_bit, sig->bit_length);
+	s->flags      = (sig->is_signed      ? COMPILED_SIGNED : 0)
+	              | (motorola            ? COMPILED_MOTOROLA : 0)
+	              | (sig->is_multiplexor ? COMPILED_MULTIPLEXOR : 0)
+	              | (sig->is_multiplexed ? COMPILED_MULTIPLEXED : 0)
+	              | (fd                  ? COMPILED_FD : 0);
+	compile_span(s, motorola);
+	if (sig->is_floating)
+		s->flags |= sig->sigval == 2 ? COMPILED_DOUBLE : COMPILED_FLOAT;
+
+	m->name      = sig->name;
+	m->units     = sig->units;
+	m->comment   = sig->comment;
+	m->ecus      = sig->ecus;
+	m->ecu_count = sig->ecu_count;
+	m->val_list  = sig->val_list;
+	m->signal    = sig;
+}
+
+const compiled_t *dbc_compile(dbc_t *dbc)
+{
+	assert(dbc);
+	if (dbc->compiled)
+		return dbc->compiled;
+	compiled_t *c = arena_allocate(dbc->arena, sizeof(*c));
+	for (size_t i = 0; i < dbc->message_count; i++)
+		c->signal_count += dbc->messages[i]->signal_count;
+	c->message_count = dbc->message_count;
+	c->messages = arena_allocate(dbc->arena, (c->message_count + 1) * sizeof(*c->messages));
+	c->signals  = arena_allocate(dbc->arena, (c->signal_count + 1) * sizeof(*c->signals));
+	c->meta     = arena_allocate(dbc->arena, (c->signal_count + 1) * sizeof(*c->meta));
+
+	for (size_t i = 0, k = 0; i < dbc->message_count; i++) {
+		can_msg_t *msg = dbc->messages[i];
+		compiled_message_t *cm = &c->messages[i];
+		cm->id          = msg->id;
+		cm->dlc         = msg->dlc;
+		cm->is_extended = msg->is_extended;
+		cm->is_fd       = compiled_is_fd(msg);
+		cm->first       = k;
+		cm->count       = msg->signal_count;
+		cm->multiplexor = SIZE_MAX;
+		cm->message     = msg;
+		for (size_t j = 0; j < msg->signal_count; j++, k++) {
+			compile_signal(&c->signals[k], &c->meta[k], msg->sigs[j], cm->is_fd);
+			cm->flags |= c->signals[k].flags;
+			if (msg->sigs[j]->is_multiplexor && cm->multiplexor == SIZE_MAX)
+				cm->multiplexor = k;
+		}
+	}
+	debug("compiled: %zu messages, %zu signals, %zu bytes of signal descriptors",
+			c->message_count, c->signal_count, c->signal_count * sizeof(*c->signals));
+	dbc->compiled = c;
+	return c;
+}
+
+static uint64_t reverse_byte_order(uint64_t x)
+{
+	uint64_t r = 0;
+	for (unsigned i = 0; i < 8; i++, x >>= 8)
+		r = (r << 8) | (x & 0xFF);
+	return r;
+}
+
+uint64_t compiled_raw(const compiled_signal_t *s, uint64_t data)
+{
+	assert(s);
+	assert(!(s->flags & COMPILED_FD));
+	if (s->flags & COMPILED_MOTOROLA)
+		data = reverse_byte_order(data);
+	uint64_t x = (data >> s->shift) & s->mask;
+	if (x & s->sign)
+		x |= ~s->mask;
+	return x;
+}
+
+/* The ninth byte a signal can straddle is added in on its own */
+uint64_t compiled_raw_bytes(const compiled_signal_t *s, const uint8_t *data, size_t length)
+{
+	assert(s);
+	assert(data || s->bytes == 0);
+	assert(((size_t)s->first + s->bytes) <= length || s->bytes == 0);
+	const unsigned n = s->bytes < 8 ? s->bytes : 8;
+	const uint8_t *d = data + s->first;
+	uint64_t x = 0;
+	if (s->flags & COMPILED_MOTOROLA) {
+		for (unsigned i = 0; i < n; i++)
+			x = (x << 8) | d[i];
+		x = s->bytes == 9 ? (x << (8 - s->bytes_shift)) | (d[8] >> s->bytes_shift) : x >> s->bytes_shift;
+	} else {
+		for (unsigned i = n; i--; )
+			x = (x << 8) | d[i];
+		x >>= s->bytes_shift;
+		if (s->bytes == 9)
+			x |= (uint64_t)d[8] << (64 - s->bytes_shift);
+	}
+	x &= s->mask;
+	if (x & s->sign)
+		x |= ~s->mask;
+	return x;
+}
+
+/* The host is assumed to use IEEE-754, unlike the generated code */
+double compiled_physical(const compiled_signal_t *s, uint64_t raw)
+{
+	assert(s);
+	double v = 0;
+	if (s->flags & COMPILED_FLOAT) {
+		float f = 0;
+		uint32_t u = raw;
+		memcpy(&f, &u, sizeof(f));
+		v = f;
+	} else if (s->flags & COMPILED_DOUBLE) {
+		memcpy(&v, &raw, sizeof(v));
+	} else if (s->flags & COMPILED_SIGNED) {
+		v = (int64_t)raw;
+	} else {
+		v = raw;
+	}
+	return (v * s->scaling) + s->offset;
+}
+
+void compiled_unpack(const compiled_t *c, const compiled_message_t *m, uint64_t data, double *values)
+{
+	assert(c);
+	assert(m);
+	assert(values);
+	assert(!m->is_fd);
+	const compiled_signal_t *s = &c->signals[m->first];
+	for (size_t i = 0; i < m->count; i++)
+		values[i] = compiled_physical(&s[i], compiled_raw(&s[i], data));
+}
+
+void compiled_unpack_bytes(const compiled_t *c, const compiled_message_t *m, const uint8_t *data, size_t length, double *values)
+{
+	assert(c);
+	assert(m);
+	assert(values);
+	const compiled_signal_t *s = &c->signals[m->first];
+	for (size_t i = 0; i < m->count; i++)
+		values[i] = compiled_physical(&s[i], compiled_raw_bytes(&s[i], data, length));
+}
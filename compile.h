@@ -0,0 +1,122 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef COMPILE_H
+#define COMPILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* A compiled view of a resolved database, the fields needed to pack and
+ * unpack a signal are held in one contiguous array with the signals of each
+ * message next to each other, everything else about a signal (its name,
+ * units, comment, ...) is held at the same index in a separate table. The
+ * view is built once, from the database arena, by dbc_compile. */
+
+enum {
+	COMPILED_SIGNED      = 1u << 0,
+	COMPILED_FLOAT       = 1u << 1, /**< IEEE-754 single precision */
+	COMPILED_DOUBLE      = 1u << 2, /**< IEEE-754 double precision */
+	COMPILED_MOTOROLA    = 1u << 3, /**< big endian, else little endian (intel) */
+	COMPILED_MULTIPLEXOR = 1u << 4,
+	COMPILED_MULTIPLEXED = 1u << 5, /**< only valid if the multiplexor is "switchval" */
+	COMPILED_FD          = 1u << 6, /**< in a CAN-FD message, see compiled_is_fd */
+};
+
+typedef struct {
+	uint64_t mask;      /**< mask for the raw value once shifted down */
+	uint64_t sign;      /**< sign bit of the raw value, zero if unsigned */
+	double scaling;
+	double offset;
+	double minimum;
+	double maximum;
+	uint32_t switchval; /**< multiplexor value selecting this signal */
+	uint16_t start_bit; /**< as given in the DBC file */
+	uint8_t bit_length;
+	uint8_t shift;      /**< right shift of the raw value in the (byte swapped if big endian) data, zero for CAN-FD */
+	uint8_t flags;      /**< COMPILED_* bits */
+	uint8_t first;      /**< first byte of the payload the signal is in */
+	uint8_t bytes;      /**< number of bytes it is in, up to nine */
+	uint8_t bytes_shift; /**< right shift of the raw value in those bytes, loaded in its byte order */
+} compiled_signal_t;
+
+typedef struct {
+	const char *name;
+	const char *units;
+	const char *comment; /**< may be NULL */
+	char **ecus;
+	size_t ecu_count;
+	val_list_t *val_list; /**< may be NULL */
+	signal_t *signal;     /**< signal this was compiled from */
+} compiled_meta_t;
+
+typedef struct {
+	unsigned long id;  /**< identifier, 11 or 29 bit */
+	size_t first;      /**< index of first signal in compiled_t "signals" and "meta" */
+	size_t count;      /**< number of signals */
+	size_t multiplexor; /**< index of the multiplexor, or SIZE_MAX if there is none */
+	unsigned dlc;
+	bool is_extended;
+	bool is_fd;        /**< a CAN-FD message, it cannot be unpacked from a 64-bit word */
+	uint8_t flags;     /**< COMPILED_* bits of all signals or-ed together */
+	can_msg_t *message; /**< message this was compiled from */
+} compiled_message_t;
+
+typedef struct compiled_t {
+	size_t message_count;
+	size_t signal_count;
+	compiled_message_t *messages; /**< in the same order as dbc_t "messages" */
+	compiled_signal_t *signals;   /**< in start bit order within each message */
+	compiled_meta_t *meta;        /**< parallel to "signals" */
+} compiled_t;
+
+/* Compiles a database that has been resolved (see dbc_resolve), the result
+ * is cached in the database and should not be modified. */
+const compiled_t *dbc_compile(dbc_t *dbc);
+
+/* A message is packed and unpacked as CAN-FD, from a byte buffer, if it is
+ * longer than a classic CAN message or if its signals are. */
+bool compiled_is_fd(const can_msg_t *msg);
+
+/* The shift and mask used to extract a signal, shared with the code
+ * generators so the generated code and the compiled view agree. The shift
+ * is only defined for the signals of classic messages, which are within a
+ * 64-bit word. */
+unsigned compiled_shift(bool motorola, unsigned start_bit, unsigned bit_length);
+uint64_t compiled_mask(unsigned bit_length);
+
+/* The SIG_VALTYPE_ of a signal, 0 for an integer, 1 for a float and 2 for
+ * a double, as the backends print it */
+unsigned compiled_floating(const compiled_signal_t *s);
+
+/* Extracts the raw value of a signal, sign extended to 64 bits if signed,
+ * from a message in the format used by the generated "unpack_message", the
+ * first byte of the message is the lowest byte of "data". Like that function
+ * it only handles classic CAN messages, not CAN-FD ones (see COMPILED_FD). */
+uint64_t compiled_raw(const compiled_signal_t *s, uint64_t data);
+
+/* Extracts the raw value of a signal of any message from a payload of
+ * "length" bytes, as "unpack_message_bytes" does, the payload must hold
+ * every byte of the signal. */
+uint64_t compiled_raw_bytes(const compiled_signal_t *s, const uint8_t *data, size_t length);
+
+/* Converts a raw value to a physical one, applying the scaling and offset */
+double compiled_physical(const compiled_signal_t *s, uint64_t raw);
+
+/* Decodes every signal in a message into "values", which must have room for
+ * "m->count" entries, multiplexed signals are decoded whatever the value of
+ * the multiplexor is. The message must not be a CAN-FD one. */
+void compiled_unpack(const compiled_t *c, const compiled_message_t *m, uint64_t data, double *values);
+
+/* As compiled_unpack, but from a payload of "length" bytes, for any message */
+void compiled_unpack_bytes(const compiled_t *c, const compiled_message_t *m, const uint8_t *data, size_t length, double *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
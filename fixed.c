@@ -0,0 +1,171 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief Work out integer only scaling of a signal, see fixed.h. */
+#include "fixed.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRACTION_MAX (4294967296.0)        /**< 2^32, largest numerator or denominator looked for */
+#define PRODUCT_MAX  (2305843009213693952.0) /**< 2^61, leaves room for rounding and a sign */
+
+static int64_t gcd(int64_t a, int64_t b)
+{
+	a = a < 0 ? -a : a;
+	b = b < 0 ? -b : b;
+	while (b) {
+		const int64_t t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+int64_t fixed_rounded(int64_t n, int64_t d)
+{
+	assert(d > 0);
+	return n >= 0 ? (n + d / 2) / d : -((d / 2 - n) / d);
+}
+
+/* The fraction with the smallest denominator that is the same double as
+ * "x", from its continued fraction, so 0.1 becomes 1/10 and not the value of
+ * the double nearest to it. If there is none with both parts below 2^32 then
+ * the nearest multiple of 2^-32 is used instead, which is not exact. */
+static bool rational(double x, int64_t r[2])
+{
+	assert(r);
+	const double a = fabs(x);
+	double h0 = 0, h1 = 1, k0 = 1, k1 = 0, rest = a;
+	for (int i = 0; i < 64; i++) {
+		const double t = floor(rest);
+		const double h = t * h1 + h0, k = t * k1 + k0;
+		if (h >= FRACTION_MAX || k >= FRACTION_MAX)
+			break;
+		h0 = h1, h1 = h;
+		k0 = k1, k1 = k;
+		if (h1 / k1 == a) {
+			r[0] = x < 0 ? -(int64_t)h1 : (int64_t)h1;
+			r[1] = (int64_t)k1;
+			return true;
+		}
+		if (rest == t)
+			break;
+		rest = 1.0 / (rest - t);
+	}
+	const bool small = a * FRACTION_MAX < PRODUCT_MAX;
+	r[1] = small ? (int64_t)FRACTION_MAX : 1;
+	if (a < PRODUCT_MAX)
+		r[0] = (int64_t)llround(small ? x * FRACTION_MAX : x);
+	else /* far too big, fixed_signal rejects it */
+		r[0] = x < 0 ? -INT64_MAX : INT64_MAX;
+	return false;
+}
+
+static int64_t largest(int64_t a, int64_t b)
+{
+	a = a < 0 ? -a : a;
+	b = b < 0 ? -b : b;
+	return a > b ? a : b;
+}
+
+bool fixed_signal(const signal_t *sig, uint64_t denominator, bool check_min, bool check_max, fixed_t *f, const char **why)
+{
+	assert(sig);
+	assert(f);
+	assert(why);
+	assert(denominator > 0);
+	memset(f, 0, sizeof(*f));
+	*why = NULL;
+	if (sig->is_floating) {
+		*why = "it is floating point";
+		return false;
+	}
+	if (sig->bit_length == 0 || sig->bit_length > 62) {
+		*why = "it is longer than 62 bits";
+		return false;
+	}
+	const unsigned n = sig->bit_length;
+	f->rlo = sig->is_signed ? -(INT64_C(1) << (n - 1)) : 0;
+	f->rhi = sig->is_signed ? (INT64_C(1) << (n - 1)) - 1 : (INT64_C(1) << n) - 1;
+
+	const bool scaling = rational(sig->scaling, f->scaling);
+	const bool offset  = rational(sig->offset, f->offset);
+	f->exact = scaling && offset;
+	if (f->scaling[0] == 0) {
+		*why = sig->scaling == 0 ? "its scaling is zero" : "its scaling is too small for the unit";
+		return false;
+	}
+	const double d = (double)denominator;
+	if (fabs((double)f->scaling[0]) * d * (double)f->offset[1] >= PRODUCT_MAX ||
+		fabs((double)f->offset[0]) * d * (double)f->scaling[1] >= PRODUCT_MAX ||
+		(double)f->scaling[1] * (double)f->offset[1] >= PRODUCT_MAX) {
+		*why = "its scaling and offset are not fractions with small enough parts";
+		return false;
+	}
+
+	/* value = (raw * s0/s1 + o0/o1) * denominator, over a common denominator */
+	f->mul = f->scaling[0] * (int64_t)denominator * f->offset[1];
+	f->add = f->offset[0] * (int64_t)denominator * f->scaling[1];
+	f->div = f->scaling[1] * f->offset[1];
+	int64_t g = gcd(gcd(f->mul, f->add), f->div);
+	f->mul /= g, f->add /= g, f->div /= g;
+
+	/* "raw * mul", then the addition, then the rounding must all fit */
+	const double bound = (double)largest(f->rlo, f->rhi) * fabs((double)f->mul) + fabs((double)f->add) + (double)f->div;
+	if (bound >= PRODUCT_MAX) {
+		*why = "its values do not fit in 64 bits";
+		return false;
+	}
+	f->wide = bound > INT32_MAX;
+	const int64_t n0 = f->rlo * f->mul + f->add, n1 = f->rhi * f->mul + f->add;
+	const int64_t nlo = n0 < n1 ? n0 : n1, nhi = n0 < n1 ? n1 : n0;
+	f->vlo = fixed_rounded(nlo, f->div);
+	f->vhi = fixed_rounded(nhi, f->div);
+	f->value_wide = f->vlo < -INT32_MAX || f->vhi > INT32_MAX;
+
+	/* the minimum and maximum are compared with "raw * mul + add", there is
+	 * no need to if every raw value is within them */
+	const long double scale = (long double)denominator * f->div;
+	if (check_min) {
+		const long double lo = ceill(sig->minimum * scale);
+		f->has_lo = lo > nlo;
+		f->lo = f->has_lo ? (lo > nhi ? nhi + 1 : (int64_t)lo) : nlo;
+	}
+	if (check_max) {
+		const long double hi = floorl(sig->maximum * scale);
+		f->has_hi = hi < nhi;
+		f->hi = f->has_hi ? (hi < nlo ? nlo - 1 : (int64_t)hi) : nhi;
+	}
+
+	/* raw = (value * div - add) / mul */
+	f->emul = f->mul < 0 ? -f->div : f->div;
+	f->eadd = f->mul < 0 ? -f->add : f->add;
+	f->ediv = f->mul < 0 ? -f->mul : f->mul;
+	g = gcd(gcd(f->emul, f->eadd), f->ediv);
+	f->emul /= g, f->eadd /= g, f->ediv /= g;
+	if (check_min) {
+		const long double lo = ceill(sig->minimum * (long double)denominator);
+		if (lo > f->vlo)
+			f->vlo = lo > f->vhi ? f->vhi + 1 : (int64_t)lo;
+	}
+	if (check_max) {
+		const long double hi = floorl(sig->maximum * (long double)denominator);
+		if (hi < f->vhi)
+			f->vhi = hi < f->vlo ? f->vlo - 1 : (int64_t)hi;
+	}
+	const double ebound = (double)largest(f->vlo, f->vhi) * (double)f->emul + fabs((double)f->eadd) + (double)f->ediv;
+	if (ebound >= PRODUCT_MAX) {
+		*why = "encoding its values could overflow 64 bits";
+		return false;
+	}
+	f->ewide = ebound > INT32_MAX;
+
+	/* an exact fraction is only out by the rounding */
+	f->error = f->div > 1 ? 0.5 : 0.0;
+	if (!f->exact) {
+		const long double s = (long double)f->scaling[0] / f->scaling[1], o = (long double)f->offset[0] / f->offset[1];
+		f->error += (double)((fabsl(sig->scaling - s) * largest(f->rlo, f->rhi) + fabsl(sig->offset - o)) * denominator);
+	}
+	return true;
+}
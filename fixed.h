@@ -0,0 +1,56 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef FIXED_H
+#define FIXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Scaling of an integer signal without floating point, for targets without
+ * a floating point unit. A value is the physical value of the signal in units
+ * of 1/"denominator", rounded to the nearest unit (halves away from zero),
+ * so a denominator of 1000 gives thousandths and one of 65536 a Q16 number.
+ * The scaling and offset of a signal are turned back into the fractions
+ * they were most likely written as, 0.1 is 1/10, 0.05 is 1/20, and all of
+ * the arithmetic is done on integers with constants worked out here. */
+
+typedef struct {
+	int64_t scaling[2], offset[2]; /**< numerator and denominator of each */
+	bool exact;      /**< the fractions are the same doubles as the scaling and offset */
+	double error;    /**< largest difference from the exact value, in units */
+
+	/* decode: value = (raw * mul + add) / div, rounded */
+	int64_t mul, add, div;
+	int64_t lo, hi;  /**< range of "raw * mul + add" for the minimum and maximum */
+	bool has_lo, has_hi;
+	bool wide;       /**< 64-bit arithmetic is needed, else 32-bit will do */
+
+	/* encode: raw = (value * emul - eadd) / ediv, rounded */
+	int64_t emul, eadd, ediv;
+	int64_t vlo, vhi; /**< values that can be encoded, within the minimum and maximum */
+	bool ewide;
+
+	int64_t rlo, rhi; /**< range of the raw value */
+	bool value_wide;  /**< a value does not fit in 32 bits */
+} fixed_t;
+
+/* Work out the integer scaling of a signal, "check_min" and "check_max" are
+ * whether its minimum and maximum are checked. It returns false if the
+ * signal is floating point or the arithmetic could overflow 64 bits, the
+ * reason is put in "why". */
+bool fixed_signal(const signal_t *sig, uint64_t denominator, bool check_min, bool check_max, fixed_t *f, const char **why);
+
+/* Division of "n" by a positive "d" rounding halves away from zero, as the
+ * generated code does it */
+int64_t fixed_rounded(int64_t n, int64_t d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,73 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief A fixed size open addressed hash index, used to resolve the
+ * records in a DBC file to messages and signals. */
+#include "index.h"
+#include "util.h"
+#include <assert.h>
+
+typedef struct {
+	uint64_t id;
+	const void *name;
+	void *value;    /**< NULL if the slot is empty */
+} slot_t;
+
+struct index_t {
+	slot_t *slots;
+	size_t mask;    /**< number of slots minus one, slots are a power of two */
+	size_t count;   /**< entries added */
+	size_t max;     /**< maximum number of entries */
+};
+
+index_t *index_new(arena_t *a, size_t count)
+{
+	assert(a);
+	index_t *x = arena_allocate(a, sizeof(*x));
+	size_t size = 8;
+	while (size < (count + (count / 2)))
+		size *= 2;
+	x->slots = arena_allocate(a, size * sizeof(*x->slots));
+	x->mask = size - 1;
+	x->max = count;
+	return x;
+}
+
+static uint64_t mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	return h;
+}
+
+static slot_t *lookup(const index_t *x, uint64_t id, const void *name)
+{
+	assert(x);
+	size_t i = mix(id ^ mix((uintptr_t)name)) & x->mask;
+	for (;; i = (i + 1) & x->mask) {
+		slot_t *s = &x->slots[i];
+		if (!s->value || (s->id == id && s->name == name))
+			return s;
+	}
+}
+
+void *index_add(index_t *x, uint64_t id, const void *name, void *value)
+{
+	assert(x);
+	assert(value);
+	slot_t *s = lookup(x, id, name);
+	if (s->value)
+		return s->value;
+	if (x->count >= x->max)
+		error("index full: %zu entries", x->count);
+	x->count++;
+	s->id = id;
+	s->name = name;
+	s->value = value;
+	return value;
+}
+
+void *index_find(const index_t *x, uint64_t id, const void *name)
+{
+	return lookup(x, id, name)->value;
+}
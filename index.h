@@ -0,0 +1,33 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef INDEX_H
+#define INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arena.h"
+#include <stddef.h>
+#include <stdint.h>
+
+/* A fixed size hash index from a key, made up of a number and a pointer, to
+ * a value. It is used to look up records by message identifier and by an
+ * interned name (so the name is compared by pointer), either part of the
+ * key may be zero or NULL if it is not needed. The index is allocated from
+ * an arena, it has no delete function. */
+typedef struct index_t index_t;
+
+/* "count" is the maximum number of entries that will be added */
+index_t *index_new(arena_t *a, size_t count);
+
+/* Adds "value" if the key is not present, either way the value stored
+ * under the key is returned, so the first value added for a key is kept. */
+void *index_add(index_t *x, uint64_t id, const void *name, void *value);
+void *index_find(const index_t *x, uint64_t id, const void *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief String interning, an open addressed hash table with linear
+ * probing, allocated from an arena. */
+#include "intern.h"
+#include "util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define INTERN_MIN_SIZE (64u)
+
+typedef struct {
+	char *s;
+	size_t length;
+	uint32_t hash;
+} entry_t;
+
+struct intern_t {
+	arena_t *arena;
+	entry_t *entries; /**< hash table, size is always a power of two */
+	size_t size;      /**< number of slots in table */
+	size_t count;     /**< number of unique strings stored */
+};
+
+intern_t *intern_new(arena_t *a)
+{
+	assert(a);
+	intern_t *t = arena_allocate(a, sizeof(*t));
+	t->arena = a;
+	t->size = INTERN_MIN_SIZE;
+	t->entries = arena_allocate(a, t->size * sizeof(*t->entries));
+	return t;
+}
+
+static entry_t *slot(entry_t *entries, size_t size, const char *s, size_t length, uint32_t hash)
+{
+	assert(entries);
+	assert(is_power_of_two(size));
+	const size_t mask = size - 1;
+	for (size_t i = hash & mask;; i = (i + 1) & mask) {
+		entry_t *e = &entries[i];
+		if (!e->s)
+			return e;
+		if (e->hash == hash && e->length == length && !memcmp(e->s, s, length))
+			return e;
+	}
+}
+
+/* The old table is abandoned to the arena, as the table doubles in size
+ * the space wasted is at most the size of the final table. */
+static void rehash(intern_t *t)
+{
+	assert(t);
+	const size_t size = t->size * 2;
+	entry_t *entries = arena_allocate(t->arena, size * sizeof(*entries));
+	for (size_t i = 0; i < t->size; i++) {
+		entry_t *e = &t->entries[i];
+		if (e->s)
+			*slot(entries, size, e->s, e->length, e->hash) = *e;
+	}
+	t->entries = entries;
+	t->size = size;
+}
+
+char *intern(intern_t *t, const char *s, size_t length)
+{
+	assert(t);
+	assert(s);
+	const uint32_t hash = fnv1a(s, length);
+	entry_t *e = slot(t->entries, t->size, s, length, hash);
+	if (e->s)
+		return e->s;
+	if ((t->count + 1) * 2 > t->size) {
+		rehash(t);
+		e = slot(t->entries, t->size, s, length, hash);
+	}
+	e->s = arena_duplicate_n(t->arena, s, length);
+	e->length = length;
+	e->hash = hash;
+	t->count++;
+	return e->s;
+}
+
+char *intern_string(intern_t *t, const char *s)
+{
+	assert(s);
+	return intern(t, s, strlen(s));
+}
+
+char *intern_find(const intern_t *t, const char *s, size_t length)
+{
+	assert(t);
+	assert(s);
+	return slot(t->entries, t->size, s, length, fnv1a(s, length))->s;
+}
+
+size_t intern_count(const intern_t *t)
+{
+	assert(t);
+	return t->count;
+}
@@ -0,0 +1,31 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef INTERN_H
+#define INTERN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "arena.h"
+#include <stddef.h>
+
+/* A symbol table of interned strings, each distinct string is stored once
+ * so interned strings from the same table can be compared by pointer. The
+ * table and its strings live in an arena and are freed with it. */
+typedef struct intern_t intern_t;
+
+intern_t *intern_new(arena_t *a);
+char *intern(intern_t *t, const char *s, size_t length);
+char *intern_string(intern_t *t, const char *s);
+
+/* Returns the interned copy of a string or NULL if it has never been
+ * interned, nothing is added to the table. */
+char *intern_find(const intern_t *t, const char *s, size_t length);
+size_t intern_count(const intern_t *t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,188 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief Work out which bits of a payload each signal of a message uses,
+ * and check they fit and do not overlap, see layout.h. */
+#include "layout.h"
+#include "util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NO_PARENT (SIZE_MAX)
+
+typedef struct {
+	uint8_t bits[LAYOUT_BYTES];
+	unsigned first, last; /**< bytes of "bits" that can be non zero, "last" is one past the end */
+	size_t parent; /**< index of the multiplexor the signal depends on */
+} occupant_t;
+
+static unsigned count_bits(uint8_t b)
+{
+	unsigned r = 0;
+	for (; b; b &= b - 1)
+		r++;
+	return r;
+}
+
+bool layout_signal_bits(const signal_t *sig, uint8_t bits[LAYOUT_BYTES])
+{
+	assert(sig);
+	assert(bits);
+	const bool motorola = sig->endianess == endianess_motorola_e;
+	bool inside = true;
+	unsigned bit = sig->start_bit;
+	/* big endian signals start at their most significant bit and move to
+	 * the top of the next byte when they reach the bottom of one */
+	for (unsigned i = 0; i < sig->bit_length; i++) {
+		if (bit < LAYOUT_BITS)
+			bits[bit / 8] |= 1u << (bit % 8);
+		else
+			inside = false;
+		if (!motorola)
+			bit++;
+		else if (bit % 8)
+			bit--;
+		else
+			bit += 15;
+	}
+	return inside;
+}
+
+static size_t find_signal(const can_msg_t *msg, const signal_t *sig)
+{
+	assert(msg);
+	for (size_t i = 0; i < msg->signal_count; i++)
+		if (msg->sigs[i] == sig)
+			return i;
+	return NO_PARENT;
+}
+
+/* A signal is selected by a value of the multiplexor it depends on, which
+ * may itself depend on another, signals can be present at the same time if
+ * they agree on the value of each multiplexor they both depend on. The
+ * walks are bounded in case the multiplexors of a message form a loop. */
+static bool together(const can_msg_t *msg, const occupant_t *o, size_t a, size_t b)
+{
+	assert(msg);
+	assert(o);
+	const size_t n = msg->signal_count;
+	for (size_t i = a, di = 0; o[i].parent != NO_PARENT && di < n; i = o[i].parent, di++)
+		for (size_t j = b, dj = 0; o[j].parent != NO_PARENT && dj < n; j = o[j].parent, dj++)
+			if (o[i].parent == o[j].parent && msg->sigs[i]->switchval != msg->sigs[j]->switchval)
+				return false;
+	return true;
+}
+
+static void parents(const can_msg_t *msg, occupant_t *o)
+{
+	assert(msg);
+	assert(o);
+	const size_t n = msg->signal_count;
+	size_t top = NO_PARENT;
+	for (size_t i = 0; i < n; i++) {
+		signal_t *s = msg->sigs[i];
+		o[i].parent = NO_PARENT;
+		if (s->is_multiplexor && !s->is_multiplexed && top == NO_PARENT)
+			top = i;
+	}
+	/* extended multiplexing (SG_MUL_VAL_) says which signal a signal
+	 * depends on, otherwise it is the one multiplexor of the message */
+	for (size_t i = 0; i < n; i++) {
+		signal_t *s = msg->sigs[i];
+		for (size_t j = 0; j < s->mul_num; j++) {
+			const size_t child = find_signal(msg, s->muxed[j]);
+			if (child != NO_PARENT && child != i)
+				o[child].parent = i;
+		}
+	}
+	for (size_t i = 0; i < n; i++)
+		if (msg->sigs[i]->is_multiplexed && o[i].parent == NO_PARENT && top != i)
+			o[i].parent = top;
+}
+
+static unsigned branches(const can_msg_t *msg, const occupant_t *o)
+{
+	assert(msg);
+	assert(o);
+	unsigned r = 1;
+	for (size_t i = 0; i < msg->signal_count; i++) {
+		if (o[i].parent == NO_PARENT)
+			continue;
+		size_t j = 0;
+		for (; j < i; j++)
+			if (o[j].parent == o[i].parent && msg->sigs[j]->switchval == msg->sigs[i]->switchval)
+				break;
+		r += j == i;
+	}
+	return r;
+}
+
+layout_t *layout_message(dbc_t *dbc, can_msg_t *msg)
+{
+	assert(dbc);
+	assert(msg);
+	const size_t n = msg->signal_count;
+	const unsigned limit = msg->dlc < LAYOUT_BYTES ? msg->dlc * 8 : LAYOUT_BITS;
+	layout_t *l = arena_allocate(dbc->arena, sizeof(*l));
+	occupant_t *o = allocate((n + 1) * sizeof(*o));
+	parents(msg, o);
+	l->branches = branches(msg, o);
+
+	for (size_t i = 0; i < n; i++) {
+		signal_t *s = msg->sigs[i];
+		const bool payload = layout_signal_bits(s, o[i].bits);
+		unsigned set = 0, beyond = 0;
+		bool aligned = payload && s->bit_length > 0;
+		/* a signal is at most 64 bits so most of its bitmap is empty */
+		o[i].first = s->start_bit / 8 < LAYOUT_BYTES ? s->start_bit / 8 : LAYOUT_BYTES;
+		o[i].last  = o[i].first + 9 < LAYOUT_BYTES ? o[i].first + 9 : LAYOUT_BYTES;
+		for (unsigned b = o[i].first; b < o[i].last; b++) {
+			const unsigned c = count_bits(o[i].bits[b]);
+			set += c;
+			if ((b * 8) >= limit)
+				beyond += c;
+			if (o[i].bits[b] != 0 && o[i].bits[b] != 0xFF)
+				aligned = false;
+			l->used[b] |= o[i].bits[b];
+		}
+		/* bits that are not even in the largest payload */
+		beyond += s->bit_length - set;
+		l->beyond += s->bit_length - set;
+		s->layout = LAYOUT_DISJOINT;
+		s->layout |= beyond ? 0 : LAYOUT_INSIDE;
+		s->layout |= aligned ? LAYOUT_ALIGNED : 0;
+		if (beyond)
+			warning("signal '%s' of message '%s' does not fit in a DLC of %u (fix your DBC file)", s->name, msg->name, msg->dlc);
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		for (size_t j = i + 1; j < n; j++) {
+			uint8_t common[LAYOUT_BYTES];
+			const unsigned first = o[i].first > o[j].first ? o[i].first : o[j].first;
+			const unsigned last  = o[i].last  < o[j].last  ? o[i].last  : o[j].last;
+			bool shared = false;
+			for (unsigned b = first; b < last; b++) {
+				common[b] = o[i].bits[b] & o[j].bits[b];
+				shared = shared || common[b];
+			}
+			if (!shared || !together(msg, o, i, j))
+				continue;
+			for (unsigned b = first; b < last; b++)
+				l->overlap[b] |= common[b];
+			l->overlaps++;
+			msg->sigs[i]->layout &= ~LAYOUT_DISJOINT;
+			msg->sigs[j]->layout &= ~LAYOUT_DISJOINT;
+			warning("signals '%s' and '%s' of message '%s' overlap (fix your DBC file)", msg->sigs[i]->name, msg->sigs[j]->name, msg->name);
+		}
+	}
+
+	for (unsigned b = 0; b < LAYOUT_BYTES; b++) {
+		if ((b * 8) >= limit)
+			l->beyond += count_bits(l->used[b]);
+		else
+			l->gaps += 8 - count_bits(l->used[b]);
+	}
+	debug("message '%s': %u branches, %u bits unused, %u overlapping pairs", msg->name, l->branches, l->gaps, l->overlaps);
+	free(o);
+	return l;
+}
@@ -0,0 +1,51 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "can.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The layout of a message is worked out from the bits each of its signals
+ * occupies in the payload, bit "n" of a bitmap is bit "n % 8" of byte
+ * "n / 8" of the payload whatever the byte order of the signal. Signals
+ * can only overlap if they can be present at the same time, that is if
+ * they are not in different branches of a multiplexor. It is worked out
+ * for each message by dbc_resolve. */
+
+#define LAYOUT_BYTES (CAN_FD_MAX_DLC) /**< largest payload */
+#define LAYOUT_BITS  (LAYOUT_BYTES * 8u)
+
+enum { /* signal_t "layout" flags */
+	LAYOUT_INSIDE   = 1u << 0, /**< every bit is within the DLC */
+	LAYOUT_DISJOINT = 1u << 1, /**< no bit is shared with a signal that can be present at the same time */
+	LAYOUT_ALIGNED  = 1u << 2, /**< occupies whole bytes only */
+};
+
+typedef struct layout_t {
+	uint8_t used[LAYOUT_BYTES];    /**< bits used by any signal, in any branch */
+	uint8_t overlap[LAYOUT_BYTES]; /**< bits used by more than one signal at once */
+	unsigned branches; /**< number of multiplexor values signals depend on, plus one for the signals that are always present */
+	unsigned overlaps; /**< number of pairs of signals that overlap */
+	unsigned gaps;     /**< bits within the DLC that no signal uses */
+	unsigned beyond;   /**< bits used beyond the DLC */
+} layout_t;
+
+/* Set the bits a signal occupies, returns false if some of them are not
+ * within the largest payload, those bits are not set. */
+bool layout_signal_bits(const signal_t *sig, uint8_t bits[LAYOUT_BYTES]);
+
+/* Work out the layout of a resolved message, set the layout flags of its
+ * signals and warn about overlaps and bits beyond the DLC. */
+layout_t *layout_message(dbc_t *dbc, can_msg_t *msg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,20 +3,29 @@
  * @copyright Richard James Howe, SUBLEQ LTD (2025)
  * @license MIT */
 #include <assert.h>
+#include <ctype.h>
 #include <stdint.h>
 #include "mpc.h"
 #include "util.h"
 #include "can.h"
 #include "parse.h"
+#include "read.h"
 #include "2c.h"
 #include "2xml.h"
 #include "2csv.h"
 #include "2bsm.h"
 #include "2json.h"
+#include "2dbcb.h"
+#include "cache.h"
 #include "options.h"
 
 #ifndef NELEMS
 #define NELEMS(X) (sizeof(X) / sizeof((X)[0]))
+
+/* Changed whenever the output for the same input and options changes, it is
+ * part of the cache key along with the executable itself when that can be
+ * read, so that outputs cached by an older dbcc are not used. */
+#define GENERATOR_VERSION (5)
 #endif
 
 typedef enum {
@@ -25,12 +34,33 @@ typedef enum {
 	CONVERT_TO_CSV,
 	CONVERT_TO_BSM,
 	CONVERT_TO_JSON,
+	CONVERT_TO_DBCB,
 } conversion_type_e;
 
+/* The parts of a DBC file each backend uses, anything else is skipped */
+static const unsigned backend_needs[] = {
+	[CONVERT_TO_C]    = READ_COMMENTS | READ_VALUES,
+	[CONVERT_TO_XML]  = 0,
+	[CONVERT_TO_CSV]  = 0,
+	[CONVERT_TO_BSM]  = 0,
+	[CONVERT_TO_JSON] = 0,
+	[CONVERT_TO_DBCB] = READ_COMMENTS | READ_VALUES,
+};
+
+/* The files each backend writes, by suffix */
+static const char *backend_outputs[][2] = {
+	[CONVERT_TO_C]    = { "c", "h", },
+	[CONVERT_TO_XML]  = { "xml", NULL, },
+	[CONVERT_TO_CSV]  = { "csv", NULL, },
+	[CONVERT_TO_BSM]  = { "bsm", NULL, },
+	[CONVERT_TO_JSON] = { "json", NULL, },
+	[CONVERT_TO_DBCB] = { "dbcb", NULL, },
+};
+
 static void usage(const char *arg0)
 {
 	assert(arg0);
-	fprintf(stderr, "%s: [-] [-hvjgtxpkuDC] [-o dir] file*\n", arg0);
+	fprintf(stderr, "%s: [-] [-hvjgtxpkuDCSB] [-o dir] [-c dir] [-M name] [-O k=v] [-T threads] file*\n", arg0);
 }
 
 static void help(void)
@@ -50,19 +80,40 @@ Options:\n\
 \t-h     print out a help message and exit\n\
 \t-v     make the program more verbose\n\
 \t-g     print out the grammar used to parse the DBC files\n\
+\t-S     use the strict (but slower) grammar from '-g' to parse files\n\
+\t-T num number of threads used to read each file, 0 (the default) uses\n\
+\t       one per processor for large files\n\
 \t-t     add timestamps to the generated files\n\
 \t-x     convert output to XML instead of the default C code\n\
 \t-C     convert output to CSV instead of the default C code\n\
 \t-b     convert output to BSM (beSTORM) instead of the default C code\n\
 \t-j     convert output to JSON instead of the default C code\n\
+\t-B     convert output to a binary database (.dbcb) that can be read\n\
+\t       back in as an input file much faster than a DBC file\n\
 \t-D     use 'double' for the encode/decode type messages\n\
 \t-o dir set the output directory\n\
+\t-c dir cache directory, outputs that are up to date with the input file\n\
+\t       and options are not regenerated, this is ignored with '-t'\n\
+\t-M name merge all of the files into one database called 'name', each\n\
+\t       file is a bus named after the file, the generated C code has\n\
+\t       one set of functions that take the bus as well as the identifier\n\
 \t-p     generate only print code\n\
 \t-k     generate only pack code\n\
 \t-u     generate only unpack code\n\
 \t-s     disable assert generation\n\
+\t-O k=v set a C code generation option, for example 'use-doubles=yes', or\n\
+\t       'dispatch=table' or 'dispatch=hash' to find the functions for\n\
+\t       a message with a table, or hash, of identifiers instead of a switch,\n\
+\t       'generate-extract=yes' to decode a signal from many payloads,\n\
+\t       'generate-columns=yes' to unpack messages into arrays of values, or\n\
+\t       'physical=float' or 'physical=double' to unpack a message into\n\
+\t       the physical value of each signal, checked against its range, or\n\
+\t       'fixed-point=1000' or 'fixed-point=q16' for functions that decode\n\
+\t       and encode signals without floating point, in units of 1/1000\n\
+\t       or 2^-16 of their physical value, 'memoize=yes' with '-S' makes\n\
+\t       the strict grammar remember where its rules failed\n\
 \t-n [version] specify the version of the generated output. Defaults to the latest.\n\
-\tfile   process a DBC file\n\
+\tfile   process a DBC file, or a binary database made with '-B'\n\
 \n\
 Files must come after the arguments have been processed.\n\
 \n\
@@ -82,7 +133,7 @@ static char *replace_file_type(const char *file, const char *suffix)
 	assert(suffix);
 	char *name = duplicate(file);
 	char *dot = strrchr(name, '.');
-	if (*dot)
+	if (dot)
 		*dot = '\0';
 	size_t name_size = strlen(name) + strlen(suffix) + 2;
 	name = reallocator(name, name_size); /* + 1 for '.', + 1 for '\0' */
@@ -99,11 +150,13 @@ static int dbc2cWrapper(dbc_t *dbc, const char *dbc_file, const char *file_only,
 	char *cname = replace_file_type(dbc_file,  "c");
 	char *hname = replace_file_type(dbc_file,  "h");
 	char *fname = replace_file_type(file_only, "h");
-	FILE *c = fopen_or_die(cname, "wb");
-	FILE *h = fopen_or_die(hname, "wb");
-	const int r = dbc2c(dbc, c, h, fname, copts);
-	fclose(c);
-	fclose(h);
+	FILE *c = fopen_output(cname);
+	FILE *h = fopen_output(hname);
+	int r = dbc2c(dbc, c, h, fname, copts);
+	if (fclose_output(c, cname) < 0)
+		r = -1;
+	if (fclose_output(h, hname) < 0)
+		r = -1;
 	free(cname);
 	free(hname);
 	free(fname);
@@ -115,9 +168,10 @@ static int dbc2xmlWrapper(dbc_t *dbc, const char *dbc_file, bool use_time_stamps
 	assert(dbc);
 	assert(dbc_file);
 	char *name = replace_file_type(dbc_file, "xml");
-	FILE *o = fopen_or_die(name, "wb");
-	const int r = dbc2xml(dbc, o, use_time_stamps);
-	fclose(o);
+	FILE *o = fopen_output(name);
+	int r = dbc2xml(dbc, o, use_time_stamps);
+	if (fclose_output(o, name) < 0)
+		r = -1;
 	free(name);
 	return r;
 }
@@ -127,9 +181,10 @@ static int dbc2csvWrapper(dbc_t *dbc, const char *dbc_file)
 	assert(dbc);
 	assert(dbc_file);
 	char *name = replace_file_type(dbc_file, "csv");
-	FILE *o = fopen_or_die(name, "wb");
-	const int r = dbc2csv(dbc, o);
-	fclose(o);
+	FILE *o = fopen_output(name);
+	int r = dbc2csv(dbc, o);
+	if (fclose_output(o, name) < 0)
+		r = -1;
 	free(name);
 	return r;
 }
@@ -139,9 +194,23 @@ static int dbc2bsmWrapper(dbc_t *dbc, const char *dbc_file, bool use_time_stamps
 	assert(dbc);
 	assert(dbc_file);
 	char *name = replace_file_type(dbc_file, "bsm");
-	FILE *o = fopen_or_die(name, "wb");
-	const int r = dbc2bsm(dbc, o, use_time_stamps);
-	fclose(o);
+	FILE *o = fopen_output(name);
+	int r = dbc2bsm(dbc, o, use_time_stamps);
+	if (fclose_output(o, name) < 0)
+		r = -1;
+	free(name);
+	return r;
+}
+
+static int dbc2dbcbWrapper(dbc_t *dbc, const char *dbc_file)
+{
+	assert(dbc);
+	assert(dbc_file);
+	char *name = replace_file_type(dbc_file, "dbcb");
+	FILE *o = fopen_output(name);
+	int r = dbc2dbcb(dbc, o);
+	if (fclose_output(o, name) < 0)
+		r = -1;
 	free(name);
 	return r;
 }
@@ -151,14 +220,140 @@ static int dbc2jsonWrapper(dbc_t *dbc, const char *dbc_file, bool use_time_stamp
 	assert(dbc);
 	assert(dbc_file);
 	char *name = replace_file_type(dbc_file, "json");
-	FILE *o = fopen_or_die(name, "wb");
-	const int r = dbc2json(dbc, o, use_time_stamps);
-	fclose(o);
+	FILE *o = fopen_output(name);
+	int r = dbc2json(dbc, o, use_time_stamps);
+	if (fclose_output(o, name) < 0)
+		r = -1;
 	free(name);
 	return r;
 }
 
 
+/* The cache key covers the input file, the version of dbcc and everything
+ * that changes the output, including the names of the outputs. Any new
+ * option that changes the output must be added here. */
+static int cache_key(const char *program, char **inputs, size_t input_count, char **outputs, size_t count, conversion_type_e convert, bool strict, const dbc2c_options_t *copts, uint64_t *key)
+{
+	assert(program);
+	assert(inputs);
+	assert(outputs);
+	assert(copts);
+	assert(key);
+	char settings[512];
+	const int n = snprintf(settings, sizeof(settings),
+		"dbcc %s; generator %d; convert %d; strict %d; version %d; id-in-name %d; time-stamps %d; "
+		"doubles %d; print %d; pack %d; unpack %d; asserts %d; enum-can-ids %d; dispatch %d; extract %d; columns %d; physical %d; fixed %llu",
+		DBCC_VERSION, GENERATOR_VERSION, (int)convert, (int)strict, copts->version,
+		(int)copts->use_id_in_name, (int)copts->use_time_stamps,
+		(int)copts->use_doubles_for_encoding, (int)copts->generate_print,
+		(int)copts->generate_pack, (int)copts->generate_unpack,
+		(int)copts->generate_asserts, (int)copts->generate_enum_can_ids,
+		(int)copts->dispatch, (int)copts->generate_extract,
+		(int)copts->generate_columns, (int)copts->physical, (unsigned long long)copts->fixed_point);
+	if (n < 0 || (size_t)n >= sizeof(settings))
+		return -1;
+	/* a different build of dbcc may generate different code, the executable
+	 * is the same for every file so it is only read once */
+	static uint64_t executable = 0;
+	static bool hashed = false;
+	if (!hashed && cache_hash_file("/proc/self/exe", 0, &executable) < 0 && cache_hash_file(program, 0, &executable) < 0)
+		executable = 0;
+	hashed = true;
+	uint64_t seed = hash64(settings, n, executable);
+	for (size_t i = 0; i < count; i++)
+		seed = hash64(outputs[i], strlen(outputs[i]) + 1, seed);
+	/* the name of each input matters too, merged files are named buses */
+	for (size_t i = 0; i < input_count; i++) {
+		seed = hash64(inputs[i], strlen(inputs[i]) + 1, seed);
+		if (cache_hash_file(inputs[i], seed, &seed) < 0)
+			return -1;
+	}
+	*key = seed;
+	return 0;
+}
+
+/* Returns NULL if the file could not be read, a DBC file that can be
+ * parsed but not converted to a database is fatal. */
+static dbc_t *load(const char *file, parse_context_t *parser, unsigned threads, conversion_type_e convert)
+{
+	assert(file);
+	debug("reading => %s", file);
+	dbc_t *dbc = NULL;
+	if (is_dbcb_file(file)) {
+		dbc = dbcb_load(file);
+		if (!dbc)
+			warning("could not load file '%s'", file);
+	} else if (parser) {
+		mpc_ast_t *ast = parse_context_dbc_file_by_name(parser, file);
+		if (!ast) {
+			warning("could not parse file '%s'", file);
+			return NULL;
+		}
+		if (verbose(LOG_DEBUG))
+			mpc_ast_print(ast);
+		if (verbose(LOG_ALL_MESSAGES))
+			parse_context_report(parser);
+
+		dbc = ast2dbc(ast);
+		mpc_ast_delete(ast);
+		if (!dbc)
+			error("could not convert file '%s'", file);
+	} else {
+		const read_options_t ropts = { .threads = threads, .needs = backend_needs[convert], };
+		dbc = read_dbc_file_with_options(file, &ropts);
+		if (!dbc)
+			warning("could not parse file '%s'", file);
+	}
+	return dbc;
+}
+
+/* A bus is named after its file, without the directory or file type, and
+ * made into something that can be used in a C identifier */
+static char *bus_name(const char *file)
+{
+	assert(file);
+	char *path = duplicate(file);
+	char *name = duplicate(dbcc_basename(path));
+	free(path);
+	char *dot = strrchr(name, '.');
+	if (dot && dot != name)
+		*dot = '\0';
+	if (!isalpha((unsigned char)name[0]))
+		name[0] = '_';
+	for (size_t i = 0; name[i]; i++)
+		name[i] = isalnum((unsigned char)name[i]) ? name[i] : '_';
+	return name;
+}
+
+static dbc_t *load_merged(char **files, size_t count, parse_context_t *parser, unsigned threads, conversion_type_e convert)
+{
+	assert(files);
+	dbc_t **parts = allocate(count * sizeof(*parts));
+	char **buses = allocate(count * sizeof(*buses));
+	size_t loaded = 0;
+	for (; loaded < count; loaded++) {
+		if (is_dbcb_file(files[loaded])) {
+			warning("binary database '%s' cannot be merged, merge the files it was made from instead", files[loaded]);
+			break;
+		}
+		parts[loaded] = load(files[loaded], parser, threads, convert);
+		if (!parts[loaded])
+			break;
+		buses[loaded] = bus_name(files[loaded]);
+	}
+	dbc_t *dbc = NULL;
+	if (loaded == count)
+		dbc = dbc_merge(parts, (const char **)buses, count);
+	else
+		for (size_t i = 0; i < loaded; i++)
+			dbc_delete(parts[i]);
+	for (size_t i = 0; i < loaded; i++)
+		free(buses[i]);
+	free(parts);
+	free(buses);
+	return dbc;
+}
+
 static int flag(const char *v) { /* really should be case insensitive */
 	static char *y[] = { "yes", "on", "true", };
 	static char *n[] = { "no",  "off", "false", };
@@ -181,6 +376,39 @@ static int set_option(dbc2c_options_t *s, char *kv) {
 	}
 	*v++ = '\0';
 
+	if (!strcmp(k, "dispatch")) {
+		static const char *methods[] = { "switch", "table", "hash", };
+		for (size_t i = 0; i < NELEMS(methods); i++) {
+			if (!strcmp(methods[i], v)) {
+				s->dispatch = (dbc2c_dispatch_e)i;
+				return 0;
+			}
+		}
+		return -1;
+	}
+
+	if (!strcmp(k, "physical")) {
+		static const char *types[] = { "no", "float", "double", };
+		for (size_t i = 0; i < NELEMS(types); i++) {
+			if (!strcmp(types[i], v)) {
+				s->physical = (dbc2c_physical_e)i;
+				return 0;
+			}
+		}
+		return -1;
+	}
+
+	if (!strcmp(k, "fixed-point")) { /* "q16" for units of 2^-16, "1000" for thousandths */
+		char *end = NULL;
+		const bool q = *v == 'q' || *v == 'Q';
+		errno = 0;
+		const unsigned long long n = strtoull(v + q, &end, 10);
+		if (errno || end == v + q || *end || (q && n > 32) || (!q && (n < 1 || n > (1ull << 32))))
+			return -1;
+		s->fixed_point = q ? UINT64_C(1) << n : n;
+		return 0;
+	}
+
 	int r = flag(v);
 	if (r < 0) return -1;
 
@@ -191,6 +419,8 @@ static int set_option(dbc2c_options_t *s, char *kv) {
 	else if (!strcmp(k, "generate-pack"))    { s->generate_pack            = r; }
 	else if (!strcmp(k, "generate-unpack"))  { s->generate_unpack          = r; }
 	else if (!strcmp(k, "generate-asserts")) { s->generate_asserts         = r; }
+	else if (!strcmp(k, "generate-extract")) { s->generate_extract         = r; }
+	else if (!strcmp(k, "generate-columns")) { s->generate_columns         = r; }
 	else { return -2; }
 	return 0;
 }
@@ -201,6 +431,8 @@ int main(int argc, char **argv)
 	log_level_e log_level = get_log_level();
 	conversion_type_e convert = CONVERT_TO_C;
 	const char *outdir = NULL;
+	const char *cache = NULL;
+	const char *merge = NULL;
 	// TODO: Copy copts to dbc_t, use that version threaded throughout
 	// system instead.
 	dbc2c_options_t copts = {
@@ -211,11 +443,14 @@ int main(int argc, char **argv)
 		.generate_pack             =  false,
 		.generate_unpack           =  false,
 		.generate_asserts          =  true,
+		.dispatch                  =  DBC2C_DISPATCH_SWITCH,
 		.version                   =  3,
 	};
+	bool strict = false, memoize = false;
+	unsigned threads = 0;
 	int opt = 0;
 
-	while ((opt = dbcc_getopt(argc, argv, "hVvbjgxCNtDpukso:n:O:")) != -1) {
+	while ((opt = dbcc_getopt(argc, argv, "hVvbjgxCNtDpukSBso:n:O:T:c:M:")) != -1) {
 		switch (opt) {
 		case 'h':
 			usage(argv[0]);
@@ -242,6 +477,9 @@ int main(int argc, char **argv)
 		case 'C':
 			convert = CONVERT_TO_CSV;
 			break;
+		case 'B':
+			convert = CONVERT_TO_DBCB;
+			break;
 		case 'N':
 			copts.use_id_in_name = false;
 			break;
@@ -269,10 +507,39 @@ int main(int argc, char **argv)
 			outdir = dbcc_optarg;
 			debug("output directory: %s", outdir);
 			break;
+		case 'c':
+			cache = dbcc_optarg;
+			debug("cache directory: %s", cache);
+			break;
+		case 'M':
+			merge = dbcc_optarg;
+			debug("merging into: %s", merge);
+			break;
 		case 'O':
+			if (!strncmp(dbcc_optarg, "memoize=", 8)) { /* a parser option, not a C one */
+				const int r = flag(dbcc_optarg + 8);
+				if (r < 0)
+					error("Invalid -O option setting: %s", dbcc_optarg);
+				memoize = r;
+				break;
+			}
 			if (set_option(&copts, dbcc_optarg) < 0)
 				error("Invalid -O option setting: %s", dbcc_optarg);
 			break;
+		case 'S':
+			strict = true;
+			debug("using strict grammar");
+			break;
+		case 'T': {
+			char *end = NULL;
+			errno = 0;
+			const unsigned long t = strtoul(dbcc_optarg, &end, 10);
+			if (errno || !*dbcc_optarg || *end || t > 1024)
+				error("Invalid thread count: %s", dbcc_optarg);
+			threads = t;
+			debug("threads: %u", threads);
+			break;
+		}
 		case 's':
 			copts.generate_asserts = false;
 			debug("asserts disabled - apparently you think silent corruption is a good thing");
@@ -303,34 +570,46 @@ int main(int argc, char **argv)
 		copts.generate_unpack = true;
 	}
 
-	for (int i = dbcc_optind; i < argc; i++) {
-		debug("reading => %s", argv[i]);
-		mpc_ast_t *ast = parse_dbc_file_by_name(argv[i]);
-		if (!ast) {
-			warning("could not parse file '%s'", argv[i]);
-			continue;
-		}
-		if (verbose(LOG_DEBUG))
-			mpc_ast_print(ast);
-
-		dbc_t *dbc = ast2dbc(ast);
-		if (!dbc) {
-			return 1;
-		}
-		dbc->version = copts.version;
+	parse_context_t *parser = strict ? parse_context_new() : NULL;
+	if (parser)
+		parse_context_memoize(parser, memoize);
 
-		char *outpath = dbcc_basename(argv[i]);
+	for (int i = dbcc_optind; i < argc; i++) {
+		/* when merging, all of the remaining files make one database */
+		char **inputs = &argv[i];
+		const size_t input_count = merge ? (size_t)(argc - i) : 1;
+		char *name = merge ? duplicate(merge) : argv[i];
+		char *outpath = dbcc_basename(name);
 		if (outdir) {
 			outpath = allocate(strlen(outpath) + strlen(outdir) + 2 /* '/' + '\0'*/);
 			strcat(outpath, outdir);
 			strcat(outpath, "/");
-			strcat(outpath, dbcc_basename(argv[i]));
+			strcat(outpath, dbcc_basename(name));
 		}
 
+		char *outputs[2] = { NULL, NULL, };
+		size_t output_count = 0;
+		for (; output_count < NELEMS(outputs) && backend_outputs[convert][output_count]; output_count++)
+			outputs[output_count] = replace_file_type(outpath, backend_outputs[convert][output_count]);
+		uint64_t key = 0;
+		const bool cached = cache && !copts.use_time_stamps
+			&& cache_key(argv[0], inputs, input_count, outputs, output_count, convert, strict, &copts, &key) == 0;
+		if (cached && cache_hit(cache, key)) {
+			debug("up to date => %s", name);
+			goto next;
+		}
+
+		dbc_t *dbc = merge ?
+			load_merged(inputs, input_count, parser, threads, convert) :
+			load(argv[i], parser, threads, convert);
+		if (!dbc)
+			goto next;
+		dbc->version = copts.version;
+
 		int r = 0;
 		switch (convert) {
 		case CONVERT_TO_C:
-			r = dbc2cWrapper(dbc, outpath, dbcc_basename(argv[i]), &copts);
+			r = dbc2cWrapper(dbc, outpath, dbcc_basename(name), &copts);
 			break;
 		case CONVERT_TO_XML:
 			r = dbc2xmlWrapper(dbc, outpath, copts.use_time_stamps);
@@ -346,18 +625,30 @@ int main(int argc, char **argv)
 		case CONVERT_TO_JSON:
 			r = dbc2jsonWrapper(dbc, outpath, copts.use_time_stamps);
 			break;
+		case CONVERT_TO_DBCB:
+			r = dbc2dbcbWrapper(dbc, outpath);
+			break;
 		default:
 			error("invalid conversion type: %d", convert);
 		}
 		if (r < 0)
 			warning("conversion process failed: %u/%u", r, convert);
+		else if (cached && cache_store(cache, key, outputs, output_count) < 0)
+			warning("could not update cache for '%s'", name);
 
+		dbc_delete(dbc);
+next:
+		for (size_t j = 0; j < output_count; j++)
+			free(outputs[j]);
 		if (outdir)
 			free(outpath);
-		dbc_delete(dbc);
-		mpc_ast_delete(ast);
+		if (merge) {
+			free(name);
+			break;
+		}
 	}
 
+	parse_context_delete(parser);
 	return 0;
 }
 
@@ -75,6 +75,18 @@ typedef struct {
   char mem[64];
 } mpc_mem_t;
 
+enum {
+  MPC_MEMO_SLOTS_MIN = 1024
+};
+
+typedef struct {
+  mpc_parser_t *p;
+  long pos;
+  int has_error;
+  mpc_state_t state;
+  char received;
+} mpc_memo_t;
+
 typedef struct {
 
   int type;
@@ -98,6 +110,11 @@ typedef struct {
   char mem_full[MPC_INPUT_MEM_NUM];
   mpc_mem_t mem[MPC_INPUT_MEM_NUM];
 
+  mpc_counters_t *counters;
+  mpc_memo_t *memo;
+  size_t memo_slots;
+  size_t memo_num;
+
 } mpc_input_t;
 
 static mpc_input_t *mpc_input_new_string(const char *filename, const char *string) {
@@ -124,6 +141,10 @@ static mpc_input_t *mpc_input_new_string(const char *filename, const char *strin
   i->last = '\0';
 
   i->mem_index = 0;
+  i->counters = NULL;
+  i->memo = NULL;
+  i->memo_slots = 0;
+  i->memo_num = 0;
   memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
 
   return i;
@@ -154,6 +175,10 @@ static mpc_input_t *mpc_input_new_nstring(const char *filename, const char *stri
   i->last = '\0';
 
   i->mem_index = 0;
+  i->counters = NULL;
+  i->memo = NULL;
+  i->memo_slots = 0;
+  i->memo_num = 0;
   memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
 
   return i;
@@ -183,6 +208,10 @@ static mpc_input_t *mpc_input_new_pipe(const char *filename, FILE *pipe) {
   i->last = '\0';
 
   i->mem_index = 0;
+  i->counters = NULL;
+  i->memo = NULL;
+  i->memo_slots = 0;
+  i->memo_num = 0;
   memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
 
   return i;
@@ -211,6 +240,10 @@ static mpc_input_t *mpc_input_new_file(const char *filename, FILE *file) {
   i->last = '\0';
 
   i->mem_index = 0;
+  i->counters = NULL;
+  i->memo = NULL;
+  i->memo_slots = 0;
+  i->memo_num = 0;
   memset(i->mem_full, 0, sizeof(char) * MPC_INPUT_MEM_NUM);
 
   return i;
@@ -225,6 +258,7 @@ static void mpc_input_delete(mpc_input_t *i) {
 
   free(i->marks);
   free(i->lasts);
+  free(i->memo);
   free(i);
 }
 
@@ -301,6 +335,7 @@ static void mpc_input_suppress_enable(mpc_input_t *i) { i->suppress++; }
 static void mpc_input_mark(mpc_input_t *i) {
 
   if (i->backtrack < 1) { return; }
+  if (i->counters) { i->counters->marks++; }
 
   i->marks_num++;
 
@@ -348,6 +383,7 @@ static void mpc_input_unmark(mpc_input_t *i) {
 static void mpc_input_rewind(mpc_input_t *i) {
 
   if (i->backtrack < 1) { return; }
+  if (i->counters) { i->counters->rewinds++; }
 
   i->state = i->marks[i->marks_num-1];
   i->last  = i->lasts[i->marks_num-1];
@@ -966,6 +1002,7 @@ struct mpc_parser_t {
   mpc_pdata_t data;
   char type;
   char retained;
+  mpc_counters_t counters;
 };
 
 static mpc_val_t *mpcf_input_nth_free(mpc_input_t *i, int n, mpc_val_t **xs, int x) {
@@ -1065,7 +1102,9 @@ static mpc_result_t *mpc_grow_results(mpc_input_t *i, int j, mpc_result_t *resul
   return tmp_results;
 }
 
-static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_err_t **e, int depth) {
+static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_err_t **e, int depth);
+
+static int mpc_parse_step(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_err_t **e, int depth) {
 
   int j = 0, k = 0;
   mpc_result_t results_stk[MPC_PARSE_STACK_MIN];
@@ -1338,6 +1377,107 @@ static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_e
 #undef MPC_FAILURE
 #undef MPC_PRIMITIVE
 
+/*
+** Memoization
+**
+** Only failures of named parsers are memoized, a failure is only recorded
+** if the parser did not consume any input (mpc_check can fail after
+** consuming input) and backtracking is enabled. Errors are stored as the
+** position and character they occurred at, anything a failing parser
+** merged into the accumulated error is lost.
+*/
+
+static unsigned long mpc_memo_hash(mpc_parser_t *p, long pos) {
+  unsigned long h = (unsigned long)(size_t)p;
+  h ^= (unsigned long)pos * 2654435761ul;
+  h ^= h >> 15;
+  return h;
+}
+
+static mpc_memo_t *mpc_memo_slot(mpc_memo_t *memo, size_t slots, mpc_parser_t *p, long pos) {
+  size_t j = mpc_memo_hash(p, pos) & (slots - 1);
+  while (memo[j].p && !(memo[j].p == p && memo[j].pos == pos)) {
+    j = (j + 1) & (slots - 1);
+  }
+  return &memo[j];
+}
+
+static mpc_memo_t *mpc_memo_find(mpc_input_t *i, mpc_parser_t *p) {
+  mpc_memo_t *m;
+  if (!i->memo || i->backtrack < 1) { return NULL; }
+  m = mpc_memo_slot(i->memo, i->memo_slots, p, i->state.pos);
+  return m->p ? m : NULL;
+}
+
+static void mpc_memo_fail(mpc_input_t *i, mpc_parser_t *p, long pos, mpc_err_t *e) {
+
+  size_t j, slots;
+  mpc_memo_t *m, *memo;
+
+  if (!i->memo || i->backtrack < 1 || i->state.pos != pos) { return; }
+
+  if ((i->memo_num + 1) * 2 > i->memo_slots) {
+    slots = i->memo_slots * 2;
+    memo = calloc(slots, sizeof(mpc_memo_t));
+    for (j = 0; j < i->memo_slots; j++) {
+      if (!i->memo[j].p) { continue; }
+      *mpc_memo_slot(memo, slots, i->memo[j].p, i->memo[j].pos) = i->memo[j];
+    }
+    free(i->memo);
+    i->memo = memo;
+    i->memo_slots = slots;
+  }
+
+  m = mpc_memo_slot(i->memo, i->memo_slots, p, pos);
+  if (!m->p) { i->memo_num++; }
+  m->p = p;
+  m->pos = pos;
+  m->has_error = e != NULL;
+  if (e) {
+    m->state = e->state;
+    m->received = e->received;
+  }
+}
+
+static int mpc_parse_run(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r, mpc_err_t **e, int depth) {
+
+  int x;
+  long pos;
+  mpc_memo_t *m;
+  mpc_counters_t *counters;
+
+  if (!p->name) { return mpc_parse_step(i, p, r, e, depth); }
+
+  p->counters.calls++;
+
+  if ((m = mpc_memo_find(i, p))) {
+    p->counters.memo_hits++;
+    r->error = m->has_error ? mpc_err_new(i, p->name) : NULL;
+    if (r->error) {
+      r->error->state = m->state;
+      r->error->received = m->received;
+    }
+    return 0;
+  }
+
+  pos = i->state.pos;
+  counters = i->counters;
+  i->counters = &p->counters;
+  x = mpc_parse_step(i, p, r, e, depth);
+  i->counters = counters;
+
+  if (!x) { mpc_memo_fail(i, p, pos, r->error); }
+  return x;
+}
+
+mpc_counters_t mpc_counters(const mpc_parser_t *p) {
+  return p->counters;
+}
+
+void mpc_counters_clear(mpc_parser_t *p) {
+  memset(&p->counters, 0, sizeof(p->counters));
+}
+
 int mpc_parse_input(mpc_input_t *i, mpc_parser_t *p, mpc_result_t *r) {
   int x;
   mpc_err_t *e = mpc_err_fail(i, "Unknown Error");
@@ -1360,6 +1500,16 @@ int mpc_parse(const char *filename, const char *string, mpc_parser_t *p, mpc_res
   return x;
 }
 
+int mpc_parse_memo(const char *filename, const char *string, mpc_parser_t *p, mpc_result_t *r) {
+  int x;
+  mpc_input_t *i = mpc_input_new_string(filename, string);
+  i->memo_slots = MPC_MEMO_SLOTS_MIN;
+  i->memo = calloc(i->memo_slots, sizeof(mpc_memo_t));
+  x = mpc_parse_input(i, p, r);
+  mpc_input_delete(i);
+  return x;
+}
+
 int mpc_nparse(const char *filename, const char *string, size_t length, mpc_parser_t *p, mpc_result_t *r) {
   int x;
   mpc_input_t *i = mpc_input_new_nstring(filename, string, length);
@@ -71,6 +71,29 @@ int mpc_parse_file(const char *filename, FILE *file, mpc_parser_t *p, mpc_result
 int mpc_parse_pipe(const char *filename, FILE *pipe, mpc_parser_t *p, mpc_result_t *r);
 int mpc_parse_contents(const char *filename, mpc_parser_t *p, mpc_result_t *r);
 
+/*
+** Memoized parsing records which named parsers failed at which input
+** positions so they are not retried, a failed parse may report a less
+** precise error than mpc_parse would.
+*/
+
+int mpc_parse_memo(const char *filename, const char *string, mpc_parser_t *p, mpc_result_t *r);
+
+/*
+** Counters, collected for named parsers, marks and rewinds are attributed
+** to the innermost named parser being run.
+*/
+
+typedef struct {
+  long calls;
+  long marks;
+  long rewinds;
+  long memo_hits;
+} mpc_counters_t;
+
+mpc_counters_t mpc_counters(const mpc_parser_t *p);
+void mpc_counters_clear(mpc_parser_t *p);
+
 /*
 ** Function Types
 */
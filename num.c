@@ -0,0 +1,189 @@
+/* @copyright SUBLEQ LTD. (2025)
+ * @license MIT
+ * @brief Number conversion without sscanf, this is faster, is not affected
+ * by the locale and detects overflow.
+ *
+ * Doubles are converted exactly using the method described in "How to Read
+ * Floating Point Numbers Accurately" (William D. Clinger, 1990) when the
+ * significand and power of ten are both exactly representable, which covers
+ * nearly all numbers found in DBC files, and with strtod otherwise. Numbers
+ * too large to be represented are an error, rather than infinity. */
+#include "num.h"
+#include <assert.h>
+#include <errno.h>
+#include <float.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool digit(int ch)
+{
+	return ch >= '0' && ch <= '9';
+}
+
+/* Digits only, no sign */
+static int digits(const char *s, size_t length, uint64_t *out)
+{
+	assert(s);
+	assert(out);
+	if (!length)
+		return -1;
+	uint64_t r = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (!digit(s[i]))
+			return -1;
+		const unsigned d = s[i] - '0';
+		if (r > (UINT64_MAX - d) / 10u)
+			return -1;
+		r = (r * 10u) + d;
+	}
+	*out = r;
+	return 0;
+}
+
+int num_u64(const char *s, size_t length, uint64_t *out)
+{
+	assert(s);
+	assert(out);
+	if (length && *s == '+') {
+		s++;
+		length--;
+	}
+	return digits(s, length, out);
+}
+
+int num_i64(const char *s, size_t length, int64_t *out)
+{
+	assert(s);
+	assert(out);
+	bool negative = false;
+	if (length && (*s == '+' || *s == '-')) {
+		negative = *s == '-';
+		s++;
+		length--;
+	}
+	uint64_t u = 0;
+	if (digits(s, length, &u) < 0)
+		return -1;
+	const uint64_t limit = negative ? (uint64_t)INT64_MAX + 1u : (uint64_t)INT64_MAX;
+	if (u > limit)
+		return -1;
+	*out = negative ? (u == limit ? INT64_MIN : -(int64_t)u) : (int64_t)u;
+	return 0;
+}
+
+/* strtod uses the decimal point of the current locale, so the number is
+ * copied and its '.' replaced with it. */
+static int slow(const char *s, size_t length, double *out)
+{
+	assert(s);
+	assert(out);
+	const char *point = localeconv()->decimal_point;
+	const size_t plen = strlen(point);
+	char small[128], *buf = small;
+	if ((length * plen) + 1 > sizeof small)
+		if (!(buf = malloc((length * plen) + 1)))
+			return -1;
+	size_t j = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (s[i] == '.') {
+			memcpy(&buf[j], point, plen);
+			j += plen;
+		} else {
+			buf[j++] = s[i];
+		}
+	}
+	buf[j] = '\0';
+	char *end = NULL;
+	errno = 0;
+	const double d = strtod(buf, &end);
+	const bool complete = end == &buf[j];
+	const bool overflow = errno == ERANGE && (d == HUGE_VAL || d == -HUGE_VAL);
+	if (buf != small)
+		free(buf);
+	if (!complete || overflow)
+		return -1;
+	*out = d;
+	return 0;
+}
+
+int num_double(const char *s, size_t length, double *out)
+{
+	assert(s);
+	assert(out);
+	static const double powers[] = {
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+		1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+		1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	const char *p = s, *end = s + length;
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+
+	/* Up to 19 significant digits are kept, any more and the exact
+	 * conversion cannot be used. */
+	uint64_t m = 0;
+	int kept = 0;
+	long exponent = 0;
+	bool truncated = false, any = false;
+	for (; p < end && digit(*p); p++, any = true) {
+		if (kept < 19) {
+			m = (m * 10u) + (*p - '0');
+			kept += m != 0;
+		} else {
+			exponent++;
+			truncated |= *p != '0';
+		}
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && digit(*p); p++, any = true) {
+			if (kept < 19) {
+				m = (m * 10u) + (*p - '0');
+				kept += m != 0;
+				exponent--;
+			} else {
+				truncated |= *p != '0';
+			}
+		}
+	}
+	if (!any)
+		return -1;
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool eneg = false;
+		if (p < end && (*p == '+' || *p == '-'))
+			eneg = *p++ == '-';
+		if (p >= end || !digit(*p))
+			return -1;
+		long e = 0;
+		for (; p < end && digit(*p); p++)
+			if (e < 100000)
+				e = (e * 10) + (*p - '0');
+		exponent += eneg ? -e : e;
+	}
+	if (p != end)
+		return -1;
+
+	if (m == 0 && !truncated) {
+		*out = negative ? -0.0 : 0.0;
+		return 0;
+	}
+#if FLT_EVAL_METHOD == 0
+	/* Both the significand and the power of ten are exact, so a single
+	 * multiplication or division is correctly rounded. */
+	const uint64_t exact = (uint64_t)1 << DBL_MANT_DIG;
+	if (!truncated && m <= exact && exponent >= -22 && exponent <= 22) {
+		double d = (double)m;
+		d = exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+		*out = negative ? -d : d;
+		return 0;
+	}
+#else
+	(void)powers;
+#endif
+	return slow(s, length, out);
+}
@@ -0,0 +1,30 @@
+/* @copyright SUBLEQ LTD (2025)
+ * @license MIT */
+#ifndef NUM_H
+#define NUM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Locale independent conversion of decimal numbers. The number must take
+ * up all "length" bytes of "s", which does not need to be NUL terminated.
+ * All functions return 0 on success and -1 if the input is not a number or
+ * is out of range, in which case "out" is not written to.
+ *
+ * Integers are an optional sign followed by digits, a '-' sign is only
+ * accepted by num_i64. Doubles are an optional sign, digits with an optional
+ * fraction, and an optional exponent; they are correctly rounded and too
+ * large a magnitude is an error. */
+int num_u64(const char *s, size_t length, uint64_t *out);
+int num_i64(const char *s, size_t length, int64_t *out);
+int num_double(const char *s, size_t length, double *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif